@@ -3,6 +3,7 @@
 #include "WindSimulator.h"
 #include "ESPDeviceClient.h"
 #include "LEDController.h"
+#include <LittleFS.h>
 #include <esp_task_wdt.h>
 
 #define WDT_TIMEOUT_SECONDS 30
@@ -51,6 +52,12 @@ const int WIND_SIZE = sizeof(myWindSpeeds) / sizeof(myWindSpeeds[0]);
 LIS2DH12 accel(&Wire, LIS2DH12_ADDR); 
 StepDetector stepDetector(&accel);    
 WindSimulator windSim(myWindSpeeds, WIND_SIZE);
+// Recorded profile of any length; replaces the array when present. The compact one is made from
+// CSV weather data by libraries/WindSimulator/extras/wind_encode, the raw one is little-endian float32 km/h at 1 Hz.
+const char* WIND_COMPACT_PROFILE_PATH = "/wind.wnd";
+const char* WIND_PROFILE_PATH = "/wind.bin";
+WindProfileSource windProfile(LittleFS, WIND_COMPACT_PROFILE_PATH);
+WindFileSource windFile(LittleFS, WIND_PROFILE_PATH);
 
 ESPDeviceClient deviceClient(SUPABASE_URL, API_BEARER_TOKEN, DEFAULT_DEVICE_NAME);
 
@@ -58,6 +65,8 @@ static unsigned long lastHeartbeatTime = 0;
 
 long unsigned lastActiveTime = 0;
 const unsigned long WIND_SPEED_UPDATE_TIME = 1000;
+const unsigned long FAN_PWM_UPDATE_TIME = 20;   // Follows the interpolated natural wind at 50 Hz
+bool bikeSpeedChanged = false;
 const unsigned long LEVEL_SHOW_TIMEOUT = 3000;
 
 enum WiFiState {
@@ -68,6 +77,23 @@ enum WiFiState {
 };
 
 WiFiState currentWiFiState = WIFI_IDLE;
+
+// Runs inside stepDetector.detectStep(); only flags the change, the fan is rewritten in loop()
+void onStepEvent(const StepDetector::Event& event, void*) {
+  switch (event.type) {
+    case StepDetector::EVENT_CADENCE_CHANGED:
+      bikeSpeedChanged = true;
+      break;
+    case StepDetector::EVENT_IDLE:
+      DEBUG_PRINTLN("Observed: Pedalling stopped.");
+      break;
+    case StepDetector::EVENT_RESUMED:
+      DEBUG_PRINTLN("Observed: Pedalling resumed.");
+      break;
+    default:
+      break;
+  }
+}
 unsigned long wifiConnectAttemptStartTime = 0;
 const unsigned long WIFI_CONNECT_TIMEOUT_MS = 60000;
 
@@ -83,8 +109,18 @@ void setup() {
   Serial.println("=== System Manager Debug Start ===");
 
   systemManager.begin();
-  stepDetector.begin();
+  stepDetector.begin(ACCEL_INT1_GPIO);
+  stepDetector.addObserver(onStepEvent);
   ledController.begin();
+  windSim.setInterpolation(WIND_INTERPOLATION_MONOTONE_CUBIC);  // Smooth, without gusts the profile does not have
+  if (LittleFS.begin()) {
+    // setSource() turns down a missing or empty profile, the built-in one keeps playing then
+    if (LittleFS.exists(WIND_COMPACT_PROFILE_PATH) && windSim.setSource(&windProfile)) {
+      DEBUG_PRINTLN("Streaming compact wind profile from LittleFS.");
+    } else if (LittleFS.exists(WIND_PROFILE_PATH) && windSim.setSource(&windFile)) {
+      DEBUG_PRINTLN("Streaming wind profile from LittleFS.");
+    }
+  }
 
   DEBUG_PRINTLN("Setup complete. Registering Handlers.");
 
@@ -190,46 +226,57 @@ void loop() {
   ledController.update();
   windSim.update();
 
-  bool stepDetected = stepDetector.detectStep();
+  // Step events are delivered to onStepEvent() from in here
+  stepDetector.detectStep();
 
   if (ledController.isStartingUp()) lastActiveTime = millis();
 
-  if (stepDetected) {
-    Serial.println("Step detected!");
-
-  }
+  // The fan follows a speed change right away and the natural wind every FAN_PWM_UPDATE_TIME,
+  // so it glides between profile samples; the debug line is still printed once a second
   static unsigned long lastPrintMillis = 0;
+  static unsigned long lastPwmMillis = 0;
+  static int lastPwmValue = -1;
   unsigned long currentMillis = millis();
-  if (currentMillis - lastPrintMillis >= WIND_SPEED_UPDATE_TIME) {
+  bool printDue = currentMillis - lastPrintMillis >= WIND_SPEED_UPDATE_TIME;
+  if (bikeSpeedChanged || printDue || currentMillis - lastPwmMillis >= FAN_PWM_UPDATE_TIME) {
+    bikeSpeedChanged = false;
+    lastPwmMillis = currentMillis;
     if (!systemManager.isLocked()) {
-      float bikeSpeed = stepDetector.getBikeSpeed();
-      float naturalWindSpeed = windSim.getNaturalWindSpeed();
-      float windSpeed = bikeSpeed + naturalWindSpeed;
-      if (windSpeed > 50.0) {
-        windSpeed = 50.0;
+      // In km/h * 256: map() takes integers and would otherwise move the fan in whole km/h steps
+      long bikeSpeedQ8 = stepDetector.getBikeSpeedQ8();
+      long naturalWindSpeedQ8 = windSim.getNaturalWindSpeedQ8(currentMillis);
+      long windSpeedQ8 = bikeSpeedQ8 + naturalWindSpeedQ8;
+      if (windSpeedQ8 > 50L * 256) {
+        windSpeedQ8 = 50L * 256;
       }
-      int pwmValue = map(windSpeed, 0, 50, PWM_LEVELS[systemManager.getLevel()-1].minPwm, PWM_LEVELS[systemManager.getLevel()-1].maxPwm);
+      int pwmValue = map(windSpeedQ8, 0, 50L * 256, PWM_LEVELS[systemManager.getLevel()-1].minPwm, PWM_LEVELS[systemManager.getLevel()-1].maxPwm);
 
       
       if (currentMillis - lastActiveTime >= LEVEL_SHOW_TIMEOUT) {
         ledController.waveDisplay(pwmValue, PWM_LEVELS[systemManager.getLevel()-1].minPwm,PWM_LEVELS[systemManager.getLevel()-1].maxPwm);
       }
     // Debug output
-      Serial.print("Bike Speed: ");
-      Serial.print(bikeSpeed);
-      Serial.print(" km/h | Natural Wind: ");
-      Serial.print(naturalWindSpeed);
-      Serial.print(" km/h | Combined Wind: ");
-      Serial.print(windSpeed);
-      Serial.print(" km/h | PWM: ");
-      Serial.println(pwmValue);
+      if (printDue) {
+        Serial.print("Bike Speed: ");
+        Serial.print(bikeSpeedQ8 / 256.0f);
+        Serial.print(" km/h | Natural Wind: ");
+        Serial.print(naturalWindSpeedQ8 / 256.0f);
+        Serial.print(" km/h | Combined Wind: ");
+        Serial.print(windSpeedQ8 / 256.0f);
+        Serial.print(" km/h | PWM: ");
+        Serial.println(pwmValue);
+      }
       
-    // Update 
-      ledcWrite(FAN_PWM_GPIO, pwmValue);
+    // Update only on change, most 20 ms ticks land on the same duty
+      if (pwmValue != lastPwmValue) {
+        ledcWrite(FAN_PWM_GPIO, pwmValue);
+        lastPwmValue = pwmValue;
+      }
     } else {
-      Serial.println("System is locked. PWM not updated.");
+      lastPwmValue = -1;  // Rewrite once unlocked
+      if (printDue) Serial.println("System is locked. PWM not updated.");
     }
-    lastPrintMillis = currentMillis;
+    if (printDue) lastPrintMillis = currentMillis;
   }
 
   /*
@@ -1,26 +1,39 @@
 #include "LIS2DH12.h"
 
 
+#if defined(ARDUINO)
 LIS2DH12::LIS2DH12(TwoWire *pWire,uint8_t addr)
+  : _i2c(pWire, addr)
 {
-  _deviceAddr = addr;
-  _pWire = pWire;
+  _bus = &_i2c;
   
   mode = LOW_POWER_MODE;  // Set default mode to Low-Power Mode
 
 }
+#endif
+
+LIS2DH12::LIS2DH12(LIS2DH12Transport* transport)
+#if defined(ARDUINO)
+  : _i2c(&Wire, LIS2DH12_ADDR)
+#endif
+{
+  _bus = transport;
+
+  mode = LOW_POWER_MODE;  // Set default mode to Low-Power Mode
+}
 
 bool LIS2DH12::begin(void)
 {
-  _pWire->begin();
+  _bus->begin();
   uint8_t identifier = 0;
   bool ret = false;
 
-  _reset = 1;
   readReg(REG_CARD_ID,&identifier,1);
   DBG(identifier);
   if(identifier == 0x33){
-    ret = true;
+    // Seed the register shadow, later configuration changes are write-only
+    ret = readReg(REG_CTRL_REG1 | 0x80, _ctrlReg, sizeof(_ctrlReg)) == sizeof(_ctrlReg);
+    _ctrlDirty = 0;
   }else if(identifier == 0 || identifier == 0xff){
     DBG("Communication failure");
     ret = false;
@@ -32,31 +45,29 @@ bool LIS2DH12::begin(void)
   return ret;
 }
 
-uint8_t LIS2DH12::getAcquireRate(void)
+uint16_t LIS2DH12::getAcquireRate(void)
 {
-    uint8_t reg1;
-    readReg(REG_CTRL_REG1, &reg1, 1);
-    
     // Extract the ODR (Output Data Rate) bits (bits 4 to 7)
-    uint8_t rate = (reg1 & 0xF0) >> 4;
+    uint8_t rate = (getCtrlReg(REG_CTRL_REG1) & 0xF0) >> 4;
 
     // Convert the ODR value to a meaningful rate (e.g., Hz)
     switch (rate) {
-        case 0x0: return 1;   // 1 Hz
-        case 0x1: return 10;  // 10 Hz
-        case 0x2: return 25;  // 25 Hz
-        case 0x3: return 50;  // 50 Hz
-        case 0x4: return 100; // 100 Hz
-        case 0x5: return 200; // 200 Hz
-        case 0x6: return 400; // 400 Hz
-        case 0x7: return 800; // 800 Hz
-        default:  return 0;   // Invalid or unsupported rate
+        case 0x1: return 1;    // 1 Hz
+        case 0x2: return 10;   // 10 Hz
+        case 0x3: return 25;   // 25 Hz
+        case 0x4: return 50;   // 50 Hz
+        case 0x5: return 100;  // 100 Hz
+        case 0x6: return 200;  // 200 Hz
+        case 0x7: return 400;  // 400 Hz
+        case 0x8: return 1620; // 1.620 kHz, low-power mode only
+        case 0x9: return (mode == LOW_POWER_MODE) ? 5376 : 1344;
+        default:  return 0;    // Power down or unsupported rate
     }
 }
 
 float LIS2DH12::getTimeInterval(void)
 {
-    uint8_t rate = getAcquireRate();
+    uint16_t rate = getAcquireRate();
     if (rate == 0) {
         // Return a very large value or indicate an error if rate is not supported
         return -1.0f; // Error indicator
@@ -65,12 +76,15 @@ float LIS2DH12::getTimeInterval(void)
     return 1.0f / rate;
 }
 
-void LIS2DH12::getAcceleration(int16_t* x, int16_t* y, int16_t* z)
+bool LIS2DH12::getAcceleration(int16_t* x, int16_t* y, int16_t* z)
 {
-  readReg(REG_OUT_X_L|0x80, _sDataBuffer, 6);
+  if (readReg(REG_OUT_X_L|0x80, _sDataBuffer, 6) != 6) {
+    return false;  // Leave the caller's values alone rather than return stale data
+  }
   *x = (((int16_t)_sDataBuffer[1]) << 8) | _sDataBuffer[0];
   *y = (((int16_t)_sDataBuffer[3]) << 8) | _sDataBuffer[2];
   *z = (((int16_t)_sDataBuffer[5]) << 8) | _sDataBuffer[4];
+  return true;
 }
 
 /*!
@@ -81,6 +95,9 @@ bool LIS2DH12::isDataAvailable() {
     uint8_t status = 0;
     // Read the STATUS_REG register to get the status bits
     readReg(REG_STATUS_REG, &status, 1);
+    if (status & 0x80) {
+      _overrunCount++;  // ZYXOR: a sample was overwritten before it was read
+    }
     return (status & 0x08) != 0;  // 0x08 = 0000 1000 in binary, which checks if the third bit is set
 }
 
@@ -97,9 +114,9 @@ int32_t LIS2DH12::readAccX()
 
   // Apply scale and sign based on the platform
   #if defined(__AVR__) 
-    a = - (rawData * (uint8_t)_mgScaleVel_1)/(uint8_t)_mgScaleVel_2;
+    a = - (rawData >> _shift) * _mgPerDigit;
   #else 
-    a = (rawData * (uint8_t)_mgScaleVel_1)/(uint8_t)_mgScaleVel_2;
+    a = (rawData >> _shift) * _mgPerDigit;
   #endif
 
   return a;
@@ -116,11 +133,11 @@ int32_t LIS2DH12::readAccY()
   // Combine sensorData[0] and sensorData[1] into a 16-bit signed value
   int16_t rawData = (sensorData[1] << 8) | (sensorData[0] & 0xFF);
 
-  // Apply scaling factor based on the platform
+  // Apply scale and sign based on the platform
   #if defined(__AVR__) 
-    a = - (rawData * (uint8_t)_mgScaleVel_1)/(uint8_t)_mgScaleVel_2;
+    a = - (rawData >> _shift) * _mgPerDigit;
   #else 
-    a = (rawData * (uint8_t)_mgScaleVel_1)/(uint8_t)_mgScaleVel_2;
+    a = (rawData >> _shift) * _mgPerDigit;
   #endif
 
   return a;
@@ -136,88 +153,314 @@ int32_t LIS2DH12::readAccZ()
   // Combine sensorData[0] and sensorData[1] into a 16-bit signed value
   int16_t rawData = (sensorData[1] << 8) | (sensorData[0] & 0xFF);
 
-  // Apply scaling factor based on the platform
+  // Apply scale and sign based on the platform
   #if defined(__AVR__) 
-    a = - (rawData * (uint8_t)_mgScaleVel_1)/(uint8_t)_mgScaleVel_2;
+    a = - (rawData >> _shift) * _mgPerDigit;
   #else 
-    a = (rawData * (uint8_t)_mgScaleVel_1)/(uint8_t)_mgScaleVel_2;
+    a = (rawData >> _shift) * _mgPerDigit;
   #endif
 
   return a;
 }
 
 
+void LIS2DH12::readAccMg(int16_t* x, int16_t* y, int16_t* z)
+{
+  int16_t raw[3];
+  getAcceleration(&raw[0], &raw[1], &raw[2]);
+  convertToMg(raw, raw, 3);
+  *x = raw[0];
+  *y = raw[1];
+  *z = raw[2];
+}
+
+void LIS2DH12::convertToMg(const int16_t* raw, int16_t* mg, size_t count)
+{
+  eRange_t range = (eRange_t)(getCtrlReg(REG_CTRL_REG4) & 0x30);
+
+  #define LIS2DH12_CONVERT_RANGE(R) \
+    case R: \
+      if (mode == HIGH_RESOLUTION_MODE) LIS2DH12Scale<R, HIGH_RESOLUTION_MODE>::toMg(raw, mg, count); \
+      else if (mode == NORMAL_MODE) LIS2DH12Scale<R, NORMAL_MODE>::toMg(raw, mg, count); \
+      else LIS2DH12Scale<R, LOW_POWER_MODE>::toMg(raw, mg, count); \
+      break;
+
+  switch (range) {
+    LIS2DH12_CONVERT_RANGE(eLIS2DH12_2g)
+    LIS2DH12_CONVERT_RANGE(eLIS2DH12_4g)
+    LIS2DH12_CONVERT_RANGE(eLIS2DH12_8g)
+    LIS2DH12_CONVERT_RANGE(eLIS2DH12_16g)
+  }
+  #undef LIS2DH12_CONVERT_RANGE
+}
+
 void LIS2DH12::setMode(eResolutionMode_t newMode) 
 {
+  uint8_t reg1 = getCtrlReg(REG_CTRL_REG1);
+  uint8_t reg4 = getCtrlReg(REG_CTRL_REG4);
+
+  switch (newMode) {
+    case LOW_POWER_MODE:  // Low-power mode
+      reg1 |= (1 << 3);   // Set LPen bit for Low Power Mode
+      reg4 &= ~(1 << 3);  // Ensure High-Resolution bit (HR) is cleared
+      break;
+    case NORMAL_MODE:  // Normal mode
+      reg1 &= ~(1 << 3);  // Clear LPen bit for Normal Mode
+      reg4 &= ~(1 << 3);  // Ensure High-Resolution bit (HR) is cleared
+      break;
+    case HIGH_RESOLUTION_MODE:  // High-resolution mode
+      reg1 &= ~(1 << 3);  // Clear LPen bit for High-Resolution Mode
+      reg4 |= (1 << 3);   // Set HR bit for High-Resolution Mode
+      break;
+    default:
+      DBG("Invalid mode");
+      return;
+  }
   mode = newMode;
+  updateScale();
+
+  beginConfig();
+  setCtrlReg(REG_CTRL_REG1, reg1);
+  setCtrlReg(REG_CTRL_REG4, reg4);
+  commitConfig();
 }
 
 void LIS2DH12::setRange(eRange_t range)
 {
-  switch(range){
+  DBG(range);
+  setCtrlReg(REG_CTRL_REG4, (getCtrlReg(REG_CTRL_REG4) & ~0x30) | range);
+  updateScale();
+}
+
+void LIS2DH12::updateScale(void)
+{
+  switch(getCtrlReg(REG_CTRL_REG4) & 0x30){
     case eLIS2DH12_2g:
-      _mgScaleVel_1 = 16;
+      _mgPerDigit = 16;
       break;
     case eLIS2DH12_4g:
-      _mgScaleVel_1 = 32;
+      _mgPerDigit = 32;
       break;
     case eLIS2DH12_8g:
-      _mgScaleVel_1 = 64;
+      _mgPerDigit = 64;
       break;
     default:
-      _mgScaleVel_1 = 192;
+      _mgPerDigit = 192;
       break;
   }
-  // Adjust the scale factor based on the mode
+  // Adjust the scale factor based on the mode, see LIS2DH12Scale
   if (mode == NORMAL_MODE) {
-    _mgScaleVel_1 >>= 2; // Right shift by 2 bits
-    _mgScaleVel_2  = 64;
+    _mgPerDigit >>= 2;
+    _shift = 6;
   } else if (mode == HIGH_RESOLUTION_MODE) {
-    _mgScaleVel_1 >>= 4; // Right shift by 4 bits
-    _mgScaleVel_2  = 16;
+    _mgPerDigit >>= 4;
+    _shift = 4;
+  } else {
+    _shift = 8;
   }
-
-  DBG(range);
-  writeReg(REG_CTRL_REG4,&range,1);
 }
 
 void LIS2DH12::setAcquireRate(ePowerMode_t rate)
 {
+    // Clear the ODR bits (bits 4 to 7) and set them according to the provided 'odr' value
+    uint8_t reg1 = (getCtrlReg(REG_CTRL_REG1) & 0x0F) | rate;
+
+    DBG(reg1);
 
-    uint8_t reg1, reg4;
+    // 'mode' is public, so re-apply the LPen/HR bits in the same transaction
+    beginConfig();
+    setCtrlReg(REG_CTRL_REG1, reg1);
+    setMode(mode);
+    commitConfig();
+}
 
-    readReg(REG_CTRL_REG1, &reg1, 1);
-    readReg(REG_CTRL_REG4, &reg4, 1);
+void LIS2DH12::setConfig(eResolutionMode_t newMode, eRange_t range, ePowerMode_t rate)
+{
+    beginConfig();
+    setMode(newMode);
+    setRange(range);
+    setAcquireRate(rate);
+    commitConfig();
+}
 
-    // Clear the ODR bits (bits 4 to 7) and set them according to the provided 'odr' value
-    reg1 = (reg1 & 0x0F) | rate;
-
-    // Set the mode based on the public 'mode' member variable
-    switch (mode) {
-        case LOW_POWER_MODE:  // Low-power mode
-            reg1 |= (1 << 3);   // Set LPen bit for Low Power Mode
-            reg4 &= ~(1 << 3);  // Ensure High-Resolution bit (HR) is cleared
-            break;
-        case NORMAL_MODE:  // Normal mode
-            reg1 &= ~(1 << 3);  // Clear LPen bit for Normal Mode
-            reg4 &= ~(1 << 3);  // Ensure High-Resolution bit (HR) is cleared
-            break;
-        case HIGH_RESOLUTION_MODE:  // High-resolution mode
-            reg1 &= ~(1 << 3);  // Clear LPen bit for High-Resolution Mode
-            reg4 |= (1 << 3);   // Set HR bit for High-Resolution Mode
-            break;
-        default:
-            DBG("Invalid mode");
-            return;
+void LIS2DH12::beginConfig(void)
+{
+    _configDepth++;
+}
+
+void LIS2DH12::commitConfig(void)
+{
+    if (_configDepth > 0) {
+        _configDepth--;
+    }
+    if (_configDepth > 0 || _ctrlDirty == 0) {
+        return;
     }
 
-    DBG(reg1);
-    DBG(reg4);
+    // Write the span between the first and last dirty register in one transaction
+    uint8_t first = 0;
+    uint8_t last = sizeof(_ctrlReg) - 1;
+    while (!(_ctrlDirty & (1 << first))) first++;
+    while (!(_ctrlDirty & (1 << last))) last--;
+
+    uint8_t reg = REG_CTRL_REG1 + first;
+    if (last > first) {
+        reg |= 0x80;  // Auto-increment
+    }
+    writeReg(reg, &_ctrlReg[first], last - first + 1);
+    _ctrlDirty = 0;
+}
 
-    writeReg(REG_CTRL_REG1, &reg1, 1);
-    writeReg(REG_CTRL_REG4, &reg4, 1);
+void LIS2DH12::setCtrlReg(uint8_t reg, uint8_t value)
+{
+    uint8_t index = reg - REG_CTRL_REG1;
+    if (_ctrlReg[index] != value) {
+        _ctrlReg[index] = value;
+        _ctrlDirty |= (1 << index);
+    }
+    if (_configDepth == 0) {
+        commitConfig();
+    }
+}
 
-  
+void LIS2DH12::setHighPassFilter(eHpfMode_t hpfMode, eHpfCutoff_t cutoff, bool filteredOutput)
+{
+  uint8_t reg2 = (getCtrlReg(REG_CTRL_REG2) & 0x07) | hpfMode | cutoff;
+  if (filteredOutput) {
+    reg2 |= 0x08;  // FDS
+  }
+  DBG(reg2);
+  setCtrlReg(REG_CTRL_REG2, reg2);
+}
+
+void LIS2DH12::resetHighPassFilter(void)
+{
+  uint8_t reference;
+  readReg(REG_REFERENCE, &reference, 1);
+}
+
+void LIS2DH12::setFifoMode(eFifoMode_t fifoMode, uint8_t watermark)
+{
+  uint8_t reg5 = getCtrlReg(REG_CTRL_REG5);
+  uint8_t fifoCtrl = eFIFO_Bypass;
+
+  if (fifoMode == eFIFO_Bypass) {
+    reg5 &= ~0x40;  // Clear FIFO_EN
+  } else {
+    reg5 |= 0x40;   // Set FIFO_EN
+  }
+
+  // Going through bypass mode empties the FIFO
+  writeReg(REG_FIFO_CTRL_REG, &fifoCtrl, 1);
+  setCtrlReg(REG_CTRL_REG5, reg5);
+
+  if (fifoMode != eFIFO_Bypass) {
+    fifoCtrl = fifoMode | (watermark & 0x1F);
+    writeReg(REG_FIFO_CTRL_REG, &fifoCtrl, 1);
+  }
+  _fifoCtrl = fifoCtrl;
+  DBG(reg5);
+  DBG(fifoCtrl);
+}
+
+uint8_t LIS2DH12::getFifoLevel(void)
+{
+  uint8_t src = 0;
+  if (readReg(REG_FIFO_SRC_REG, &src, 1) == 0) {
+    return 0;
+  }
+  _fifoSrc = src;
+
+  // FSS only counts to 31, OVRN_FIFO means all 32 slots are full
+  if (src & 0x40) {
+    _overrunCount++;
+    return LIS2DH12_FIFO_SIZE;
+  }
+  return src & 0x1F;
+}
+
+bool LIS2DH12::isFifoOverrun(void)
+{
+  return (_fifoSrc & 0x40) != 0;
+}
+
+size_t LIS2DH12::readFifo(int16_t* xyz, size_t maxSamples)
+{
+  if (xyz == NULL || maxSamples == 0) {
+    return 0;
+  }
+
+  size_t queued = getFifoLevel();
+  if (queued > maxSamples) {
+    queued = maxSamples;
+  }
+
+  size_t burstLimit = _bus->maxReadSize() / 6;
+  if (burstLimit == 0) {
+    burstLimit = 1;
+  }
+
+  size_t count = 0;
+  while (count < queued) {
+    size_t burst = queued - count;
+    if (burst > burstLimit) {
+      burst = burstLimit;
+    }
+    // Output registers are little endian, read them straight into the caller's buffer
+    if (readReg(REG_OUT_X_L | 0x80, &xyz[count * 3], burst * 6) == 0) {
+      break;
+    }
+    count += burst;
+  }
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  for (size_t i = 0; i < count * 3; i++) {
+    uint16_t v = (uint16_t)xyz[i];
+    xyz[i] = (int16_t)((v << 8) | (v >> 8));
+  }
+#endif
+
+  return count;
+}
+
+#if defined(ARDUINO)
+void LIS2DH12::beginInt1(uint8_t pin, eInt1Route_t route)
+{
+  // Replace any previous data-ready/FIFO routing, keep the inertial interrupt bits
+  uint8_t reg3 = (getCtrlReg(REG_CTRL_REG3) & ~(eINT1_DataReady | eINT1_FifoWatermark | eINT1_FifoOverrun)) | route;
+  setCtrlReg(REG_CTRL_REG3, reg3);
+  DBG(reg3);
+
+  _int1Pin = pin;
+  pinMode(pin, INPUT);
+  attachInterruptArg(digitalPinToInterrupt(pin), int1Isr, this, RISING);
+}
+
+void IRAM_ATTR LIS2DH12::int1Isr(void* arg)
+{
+  LIS2DH12* self = (LIS2DH12*)arg;
+  self->_int1Events.push(micros());
+}
+#endif
+
+bool LIS2DH12::popInt1Event(uint32_t* timestampUs)
+{
+  return _int1Events.pop(timestampUs);
+}
+
+bool LIS2DH12::isInt1Asserted(void)
+{
+#if defined(ARDUINO)
+  if (_int1Pin >= 0) {
+    return digitalRead(_int1Pin) == HIGH;
+  }
+#endif
+  return false;
+}
+
+uint32_t LIS2DH12::getInt1Dropped(void)
+{
+  return _int1Events.dropped();
 }
 
 uint8_t LIS2DH12::getID()
@@ -227,74 +470,83 @@ uint8_t LIS2DH12::getID()
   return identifier;
 }
 
-void LIS2DH12::writeReg(uint8_t reg, const void * pBuf, size_t size)
+bool LIS2DH12::writeReg(uint8_t reg, const void * pBuf, size_t size)
 {
-  if(pBuf == NULL){
-	  DBG("pBuf ERROR!! : null pointer");
-  }
-  uint8_t * _pBuf = (uint8_t *)pBuf;
-  _pWire->beginTransmission(_deviceAddr);
-  _pWire->write(&reg, 1);
+  bool ok = _bus->writeReg(reg, pBuf, size);
+  checkRecovery();
+  return ok;
+}
 
-  for(uint16_t i = 0; i < size; i++){
-    _pWire->write(_pBuf[i]);
-  }
-  _pWire->endTransmission();
+size_t LIS2DH12::readReg(uint8_t reg, void* pBuf, size_t size)
+{
+  size_t n = _bus->readReg(reg, pBuf, size);
+  checkRecovery();
+  return n;
 }
 
-uint8_t LIS2DH12::readReg(uint8_t reg, void* pBuf, size_t size)
+void LIS2DH12::checkRecovery(void)
 {
-  if(pBuf == NULL){
-    DBG("pBuf ERROR!! : null pointer");
-  }
-  uint8_t * _pBuf = (uint8_t *)pBuf;
-  _pWire->beginTransmission(_deviceAddr);
-  _pWire->write(&reg, 1);
-  if( _pWire->endTransmission() != 0){
-      return 0;
+  uint32_t recoveries = _bus->getStats().recoveries;
+  if (recoveries != _seenRecoveries) {
+    _seenRecoveries = recoveries;
+    restoreConfig();
   }
-  _pWire->requestFrom(_deviceAddr, (uint8_t) size);
-  for(uint16_t i = 0; i < size; i++){
-	  
-    _pBuf[i] = _pWire->read();
+}
+
+void LIS2DH12::restoreConfig(void)
+{
+  DBG("restore configuration");
+  // A bus reset may have come with a sensor brown-out, write the whole shadow back
+  _bus->writeReg(REG_CTRL_REG1 | 0x80, _ctrlReg, sizeof(_ctrlReg));
+  _bus->writeReg(REG_FIFO_CTRL_REG, &_fifoCtrl, 1);
+  _ctrlDirty = 0;
+}
+
+void LIS2DH12::setBusClock(uint32_t hz)
+{
+  _bus->setClock(hz);
+}
+
+uint8_t LIS2DH12::thresholdToReg(uint8_t threshold)
+{
+  // INT_THS LSB is 16/32/62/186 mg for 2/4/8/16 g, independent of the resolution mode
+  uint16_t lsbMg;
+  switch(getCtrlReg(REG_CTRL_REG4) & 0x30){
+    case eLIS2DH12_2g: lsbMg = 16; break;
+    case eLIS2DH12_4g: lsbMg = 32; break;
+    case eLIS2DH12_8g: lsbMg = 62; break;
+    default:           lsbMg = 186; break;
   }
-  return size;
+  uint32_t reg = (threshold * 1000UL) / lsbMg;
+  return reg > 0x7F ? 0x7F : (uint8_t)reg;
 }
 
 void LIS2DH12::setInt1Th(uint8_t threshold)
 {
-    uint8_t reg = (threshold * 1024)/_mgScaleVel_1;
-    uint8_t reg1 = 0x08;
-    uint8_t reg2 = 0x00;
-    uint8_t data = 0x40;
+    uint8_t reg = thresholdToReg(threshold);
 
-    writeReg(REG_CTRL_REG2,&reg2,1);
-    writeReg(REG_CTRL_REG3,&data,1);
-    writeReg(REG_CTRL_REG5,&reg1,1);
-    writeReg(REG_CTRL_REG6,&reg2,1);
+    beginConfig();
+    setCtrlReg(REG_CTRL_REG2, getCtrlReg(REG_CTRL_REG2) & ~0x01);  // HP_IA1 off
+    setCtrlReg(REG_CTRL_REG3, getCtrlReg(REG_CTRL_REG3) | 0x40);   // I1_IA1 on INT1
+    setCtrlReg(REG_CTRL_REG5, getCtrlReg(REG_CTRL_REG5) | 0x08);   // LIR_INT1
+    commitConfig();
     writeReg(REG_INT1_THS,&reg,1);
-    readReg(REG_CTRL_REG5,&reg2,1);
-    DBG(reg2);
-    readReg(REG_CTRL_REG3,&reg2,1);
-    DBG(reg2);
+    DBG(getCtrlReg(REG_CTRL_REG5));
+    DBG(getCtrlReg(REG_CTRL_REG3));
 }
 
 void LIS2DH12::setInt2Th(uint8_t threshold)
 {
-    uint8_t reg = (threshold * 1024)/_mgScaleVel_1;
-    uint8_t reg1 = 0x02;
-    uint8_t reg2 = 0x00;
-    uint8_t data = 0x40;
+    uint8_t reg = thresholdToReg(threshold);
 
-    writeReg(REG_CTRL_REG2,&reg2,1);
-    writeReg(REG_CTRL_REG3,&reg2,1);
-    writeReg(REG_CTRL_REG5,&reg1,1);
-    writeReg(REG_CTRL_REG6,&data,1);
+    beginConfig();
+    setCtrlReg(REG_CTRL_REG2, getCtrlReg(REG_CTRL_REG2) & ~0x02);  // HP_IA2 off
+    setCtrlReg(REG_CTRL_REG5, getCtrlReg(REG_CTRL_REG5) | 0x02);   // LIR_INT2
+    setCtrlReg(REG_CTRL_REG6, getCtrlReg(REG_CTRL_REG6) | 0x40);
+    commitConfig();
     writeReg(REG_INT2_THS,&reg,1);
-    readReg(REG_CTRL_REG5,&reg2,1);
-    DBG(reg2);
-    readReg(REG_CTRL_REG6,&reg2,1);
-    DBG(reg2);
+    DBG(getCtrlReg(REG_CTRL_REG5));
+    DBG(getCtrlReg(REG_CTRL_REG6));
 }
 
 void LIS2DH12::enableInterruptEvent(eInterruptSource_t source,eInterruptEvent_t event)
@@ -307,8 +559,10 @@ void LIS2DH12::enableInterruptEvent(eInterruptSource_t source,eInterruptEvent_t
   else
     writeReg(REG_INT2_CFG,&data,1);
 
+#ifdef ENABLE_DBG
   readReg(REG_INT1_CFG,&data,1);
   DBG(data);
+#endif
 }
 
 bool LIS2DH12::getInt1Event(eInterruptEvent_t event)
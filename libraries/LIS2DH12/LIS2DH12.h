@@ -1,13 +1,11 @@
 #ifndef LIS2DH12_H
 #define LIS2DH12_H
 
-#include "Arduino.h"
-#include <Wire.h>
-#include <SPI.h>
+#include "LIS2DH12Transport.h"
 
 //#define ENABLE_DBG
 
-#ifdef ENABLE_DBG
+#if defined(ENABLE_DBG) && defined(ARDUINO)
 #define DBG(...) {Serial.print("["); Serial.print(__FUNCTION__); Serial.print("(): "); Serial.print(__LINE__); Serial.print(" ] "); Serial.println(__VA_ARGS__);}
 #else
 #define DBG(...)
@@ -15,11 +13,62 @@
 
 #define LIS2DH12_ADDR    0x18
 
+#define LIS2DH12_FIFO_SIZE 32   ///< Depth of the on-chip FIFO (samples per axis)
+
+
+#define LIS2DH12_EVENT_RING_SIZE 16  ///< INT1 timestamps buffered between two drains (power of two)
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
 
 #define AXIS_X 0  ///< X-axis index
 #define AXIS_Y 1  ///< Y-axis index
 #define AXIS_Z 2  ///< Z-axis index
 
+/**
+ * @brief Single-producer/single-consumer ring of 32-bit timestamps.
+ * push() is called from the INT1 ISR only and pop() from the main loop only,
+ * so no locking is needed: each side owns one index.
+ */
+template <uint8_t SIZE>
+class LIS2DH12EventRing
+{
+  static_assert((SIZE & (SIZE - 1)) == 0, "LIS2DH12EventRing size must be a power of two");
+public:
+  bool push(uint32_t value)
+  {
+    uint8_t head = _head;
+    uint8_t next = (head + 1) & (SIZE - 1);
+    if (next == _tail) {
+      _dropped++;
+      return false;
+    }
+    _buffer[head] = value;
+    _head = next;
+    return true;
+  }
+
+  bool pop(uint32_t* value)
+  {
+    uint8_t tail = _tail;
+    if (tail == _head) {
+      return false;
+    }
+    *value = _buffer[tail];
+    _tail = (tail + 1) & (SIZE - 1);
+    return true;
+  }
+
+  uint32_t dropped(void) const { return _dropped; }
+
+private:
+  volatile uint32_t _buffer[SIZE];
+  volatile uint8_t _head = 0;
+  volatile uint8_t _tail = 0;
+  volatile uint32_t _dropped = 0;
+};
+
 class LIS2DH12
 {
 public:
@@ -43,6 +92,9 @@ public:
   #define REG_INT2_CFG     0x34     ///<Interrupt source 2 configuration register
   #define REG_INT1_SRC     0x31     ///<Interrupt source 1 status register
   #define REG_INT2_SRC     0x35     ///<Interrupt source 2 status register
+  #define REG_REFERENCE    0x26     ///<High-pass filter reference, reading it resets the filter
+  #define REG_FIFO_CTRL_REG 0x2E    ///<FIFO control register
+  #define REG_FIFO_SRC_REG  0x2F    ///<FIFO status register
   
 public:
 /**
@@ -72,7 +124,9 @@ typedef enum{
     eDataRate_50Hz  = 0x40,
     eDataRate_100Hz = 0x50,
     eDataRate_200Hz = 0x60,
-    eDataRate_400Hz = 0x70
+    eDataRate_400Hz = 0x70,
+    eDataRate_1620Hz = 0x80,  /**<Low-power mode only>*/
+    eDataRate_1344Hz = 0x90   /**<5.376 kHz in low-power mode>*/
 }ePowerMode_t;
 
 /**
@@ -109,6 +163,49 @@ typedef enum{
   eINT2,     /**<int2>*/
 }eInterruptSource_t;
 
+/**
+ * @fn  eFifoMode_t
+ * @brief  FIFO mode selection (FM[1:0] bits of FIFO_CTRL_REG)
+ */
+typedef enum{
+  eFIFO_Bypass = 0x00,         /**<FIFO disabled, output registers hold the latest sample>*/
+  eFIFO_Fifo = 0x40,           /**<Collect until full, then stop>*/
+  eFIFO_Stream = 0x80,         /**<Collect continuously, oldest sample is overwritten when full>*/
+  eFIFO_StreamToFifo = 0xC0,   /**<Stream until the trigger event, then FIFO>*/
+}eFifoMode_t;
+
+/**
+ * @fn  eInt1Route_t
+ * @brief  Event routed to the INT1 pin (CTRL_REG3)
+ */
+typedef enum{
+  eINT1_DataReady = 0x10,      /**<I1_ZYXDA, new sample available>*/
+  eINT1_FifoWatermark = 0x04,  /**<I1_WTM, FIFO level above watermark>*/
+  eINT1_FifoOverrun = 0x02,    /**<I1_OVERRUN, FIFO full>*/
+}eInt1Route_t;
+
+/**
+ * @fn  eHpfMode_t
+ * @brief  High-pass filter mode (HPM[1:0] bits of CTRL_REG2)
+ */
+typedef enum{
+  eHPF_NormalReset = 0x00,  /**<Normal mode, reset by reading REFERENCE>*/
+  eHPF_Reference = 0x40,    /**<Reference signal for filtering>*/
+  eHPF_Normal = 0x80,       /**<Normal mode>*/
+  eHPF_AutoReset = 0xC0,    /**<Autoreset on interrupt event>*/
+}eHpfMode_t;
+
+/**
+ * @fn  eHpfCutoff_t
+ * @brief  High-pass cut-off selection (HPCF[1:0] bits of CTRL_REG2), relative to the ODR
+ */
+typedef enum{
+  eHPF_Cutoff_ODR_50 = 0x00,    /**<About ODR/50, 4 Hz at 200 Hz>*/
+  eHPF_Cutoff_ODR_100 = 0x10,   /**<About ODR/100, 2 Hz at 200 Hz>*/
+  eHPF_Cutoff_ODR_200 = 0x20,   /**<About ODR/200, 1 Hz at 200 Hz>*/
+  eHPF_Cutoff_ODR_400 = 0x30,   /**<About ODR/400, 0.5 Hz at 200 Hz>*/
+}eHpfCutoff_t;
+
 public:
 
   /**
@@ -117,10 +214,23 @@ public:
    * @param pWire I2c controller
    * @param addr  I2C address(0x19/0x18)
    */
+#if defined(ARDUINO)
   LIS2DH12(TwoWire* pWire = &Wire,uint8_t addr = LIS2DH12_ADDR);
+#endif
+
+  /**
+   * @fn LIS2DH12
+   * @brief Constructor for any bus backend
+   * @param transport LIS2DH12I2C, LIS2DH12SPI or LIS2DH12RegisterFile, must outlive the driver
+   */
+  LIS2DH12(LIS2DH12Transport* transport);
 
   eResolutionMode_t mode;  // Public variable to store the current mode
 
+  /**
+   * @fn setMode
+   * @brief Select low-power, normal or high-resolution mode (LPen in CTRL_REG1, HR in CTRL_REG4)
+   */
   void setMode(eResolutionMode_t newMode);
 
 
@@ -161,14 +271,43 @@ public:
    * @n          eDataRate_100Hz
    * @n          eDataRate_200Hz
    * @n          eDataRate_400Hz
+   * @n          eDataRate_1620Hz
+   * @n          eDataRate_1344Hz
    */
   void setAcquireRate(ePowerMode_t rate);
 
-  uint8_t getAcquireRate(void);
+  /**
+   * @fn getAcquireRate
+   * @brief Get the configured output data rate, read from the register shadow (no bus access)
+   * @return Rate in Hz, 0 when powered down
+   */
+  uint16_t getAcquireRate(void);
 
   // Method to calculate the time interval based on the acquisition rate
   float getTimeInterval(void);
 
+  /**
+   * @fn beginConfig
+   * @brief Start a batched configuration
+   * @details Until commitConfig() is called, setMode()/setRange()/setAcquireRate() and the
+   *          other control register setters only update the register shadow.
+   */
+  void beginConfig(void);
+
+  /**
+   * @fn commitConfig
+   * @brief Write the control registers changed since beginConfig()
+   * @details CTRL_REG1..CTRL_REG6 are contiguous, the dirty span is written in a single
+   *          auto-increment transaction. Nothing is sent if no value changed.
+   */
+  void commitConfig(void);
+
+  /**
+   * @fn setConfig
+   * @brief Apply mode, range and rate together in one bus transaction
+   */
+  void setConfig(eResolutionMode_t newMode, eRange_t range, ePowerMode_t rate);
+
   /**
    * @fn getID
    * @brief Get chip id
@@ -184,30 +323,48 @@ public:
    * @param z Pointer to store the acceleration (raw data) in the z direction.
    * @details This function retrieves the acceleration data for all three axes and stores them in the provided pointers.
    *          The measurement range is set by the setRange() function and could be ±2g, ±4g, ±8g, or ±16g.
+   * @return true(Succeed)/false(bus error, x/y/z are left unchanged)
    */
-  void getAcceleration(int16_t* x, int16_t* y, int16_t* z);
+  bool getAcceleration(int16_t* x, int16_t* y, int16_t* z);
 
 
   /**
    * @fn readAccX
    * @brief Get the acceleration in the x direction
-   * @return acceleration from x (unit:g), the mearsurement range is ±100g or ±200g, set by setRange() function.
+   * @return acceleration from x (unit:mg), the measurement range is set by setRange() function.
    */
   int32_t readAccX();
 
   /**
    * @fn readAccY
    * @brief Get the acceleration in the y direction
-   * @return acceleration from y(unit:g), the mearsurement range is ±100g or ±200g, set by setRange() function.
+   * @return acceleration from y (unit:mg), the measurement range is set by setRange() function.
    */
   int32_t readAccY();
 
   /**
    * @fn readAccZ
    * @brief Get the acceleration in the z direction
-   * @return acceleration from z(unit:g), the mearsurement range is ±100g or ±200g, set by setRange() function.
+   * @return acceleration from z (unit:mg), the measurement range is set by setRange() function.
    */
   int32_t readAccZ();
+
+  /**
+   * @fn readAccMg
+   * @brief Read all three axes in one transaction and convert them to mg
+   */
+  void readAccMg(int16_t* x, int16_t* y, int16_t* z);
+
+  /**
+   * @fn convertToMg
+   * @brief Convert a block of raw samples (e.g. from readFifo()) to mg for the current range and mode
+   * @param raw Raw samples
+   * @param mg Output buffer, may be the same as raw
+   * @param count Number of values (3 per sample for interleaved xyz)
+   * @details Dispatches once to the matching LIS2DH12Scale specialisation, so the
+   *          per-sample work is a shift and a constant multiply.
+   */
+  void convertToMg(const int16_t* raw, int16_t* mg, size_t count);
   
   /**
    * @fn setInt1Th
@@ -267,6 +424,127 @@ public:
    */
   bool getInt2Event(eInterruptEvent_t event);
 
+  /**
+   * @fn setHighPassFilter
+   * @brief Configure the internal high-pass filter
+   * @param hpfMode Filter mode
+   * @param cutoff Cut-off frequency, scales with the output data rate
+   * @param filteredOutput true routes filtered data to the output registers and the FIFO (FDS),
+   *        false keeps the filter for the interrupt generators only
+   * @details The HP_IA1/HP_IA2/HPCLICK bits set by other functions are preserved.
+   */
+  void setHighPassFilter(eHpfMode_t hpfMode, eHpfCutoff_t cutoff, bool filteredOutput);
+
+  /**
+   * @fn resetHighPassFilter
+   * @brief Settle the filter on the current input (dummy read of REFERENCE)
+   */
+  void resetHighPassFilter(void);
+
+  /**
+   * @fn setFifoMode
+   * @brief Enable or disable the 32-level FIFO
+   * @param fifoMode FIFO mode
+   * @n           eFIFO_Bypass,/<FIFO disabled>/
+   * @n           eFIFO_Fifo,/<Collect until full>/
+   * @n           eFIFO_Stream,/<Collect continuously, overwrite oldest>/
+   * @n           eFIFO_StreamToFifo,/<Stream until trigger, then FIFO>/
+   * @param watermark Watermark level (0-31), the WTM flag is raised once the FIFO holds more samples
+   * @details The FIFO is passed through bypass first so any stale content is discarded.
+   */
+  void setFifoMode(eFifoMode_t fifoMode, uint8_t watermark = 0);
+
+  /**
+   * @fn setBusClock
+   * @brief Change the bus clock, e.g. 400000 for I2C fast mode
+   * @details The LIS2DH12 is specified up to 400 kHz I2C and 10 MHz SPI.
+   */
+  void setBusClock(uint32_t hz);
+
+  /**
+   * @fn getBusStats
+   * @brief Transaction, failure, recovery and latency counters of the transport
+   */
+  const sLIS2DH12BusStats_t& getBusStats(void) { return _bus->getStats(); }
+
+  /**
+   * @fn restoreConfig
+   * @brief Rewrite CTRL_REG1..6 and FIFO_CTRL_REG from the driver shadow
+   * @details Done automatically after the transport recovered the bus.
+   */
+  void restoreConfig(void);
+
+  /**
+   * @fn getOverrunCount
+   * @brief Number of overruns seen so far: STATUS ZYXOR in isDataAvailable(), OVRN_FIFO in getFifoLevel()/readFifo()
+   * @details Each flagged read counts once, so the count is a lower bound on lost samples.
+   */
+  uint32_t getOverrunCount(void) { return _overrunCount; }
+
+  /**
+   * @fn getFifoLevel
+   * @brief Get the number of unread samples in the FIFO
+   * @return Number of queued samples (0-32)
+   */
+  uint8_t getFifoLevel(void);
+
+  /**
+   * @fn isFifoOverrun
+   * @brief Check whether the FIFO overflowed, as seen by the last getFifoLevel()/readFifo() call
+   * @return true if samples were overwritten before being read
+   */
+  bool isFifoOverrun(void);
+
+  /**
+   * @fn readFifo
+   * @brief Drain every queued FIFO sample with auto-increment burst reads
+   * @param xyz Buffer receiving interleaved raw samples (x0, y0, z0, x1, ...), at least 3 * maxSamples long
+   * @param maxSamples Maximum number of samples to read
+   * @return Number of samples stored in xyz
+   * @details With the FIFO enabled the output address wraps from OUT_Z_H back to OUT_X_L,
+   *          so a single read transaction returns consecutive samples, as many as
+   *          the transport's maxReadSize() allows (21 on ESP32 I2C, all 32 on SPI).
+   */
+  size_t readFifo(int16_t* xyz, size_t maxSamples);
+
+  /**
+   * @fn beginInt1
+   * @brief Route data-ready or FIFO watermark to INT1 and attach the GPIO interrupt
+   * @param pin GPIO connected to the sensor INT1 pin
+   * @param route Event to signal on INT1
+   * @n           eINT1_DataReady,/<New sample available>/
+   * @n           eINT1_FifoWatermark,/<FIFO level above watermark, see setFifoMode()>/
+   * @n           eINT1_FifoOverrun,/<FIFO full>/
+   * @details The ISR only records a micros() timestamp in a lock-free ring,
+   *          all bus traffic stays in the main loop. Uses attachInterruptArg() (ESP32 core).
+   */
+#if defined(ARDUINO)
+  void beginInt1(uint8_t pin, eInt1Route_t route);
+#endif
+
+  /**
+   * @fn popInt1Event
+   * @brief Take the oldest pending INT1 event
+   * @param timestampUs micros() value captured by the ISR
+   * @return true if an event was pending
+   */
+  bool popInt1Event(uint32_t* timestampUs);
+
+  /**
+   * @fn isInt1Asserted
+   * @brief Read the INT1 GPIO level, no bus access
+   * @details INT1 stays high while the routed condition holds, so a drain that was
+   *          late enough to miss the rising edge can still be detected.
+   * @return true if INT1 is high
+   */
+  bool isInt1Asserted(void);
+
+  /**
+   * @fn getInt1Dropped
+   * @brief Number of INT1 events lost because the ring was full
+   */
+  uint32_t getInt1Dropped(void);
+
   protected:
   /**
    * @fn readReg
@@ -276,7 +554,7 @@ public:
    * @param size  number of data to read
    * @return The number of successfully read data
    */
-  uint8_t readReg(uint8_t reg,void * pBuf ,size_t size);
+  size_t readReg(uint8_t reg,void * pBuf ,size_t size);
   
   /**
    * @fn writeReg
@@ -284,21 +562,80 @@ public:
    * @param reg register
    * @param pBuf  buf for store data to write 
    * @param size  The number of the data in pBuf
+   * @return true(Succeed)/false(Failed)
    */
-  void  writeReg(uint8_t reg,const void *pBuf,size_t size); 
+  bool  writeReg(uint8_t reg,const void *pBuf,size_t size); 
 
 private:
-  uint8_t _deviceAddr;
-  TwoWire *_pWire;
-  uint8_t _mgScaleVel_1 = 16;
-  uint8_t _mgScaleVel_2 = 256;
-  uint8_t _reset = 0;
+  LIS2DH12Transport* _bus;
+#if defined(ARDUINO)
+  LIS2DH12I2C _i2c;
+#endif
+  uint8_t _shift = 8;         // Unused low bits of the left-justified output (8/6/4 for LP/normal/HR)
+  int16_t _mgPerDigit = 16;   // Sensitivity after the shift
 
   uint8_t _sDataBuffer[6];
+  uint8_t _fifoSrc = 0;
+  uint8_t _fifoCtrl = 0;
+  uint32_t _overrunCount = 0;
+  uint32_t _seenRecoveries = 0;
+
+  int8_t _int1Pin = -1;
+  LIS2DH12EventRing<LIS2DH12_EVENT_RING_SIZE> _int1Events;
+
+#if defined(ARDUINO)
+  static void IRAM_ATTR int1Isr(void* arg);
+#endif
+
+  // Shadow of CTRL_REG1..CTRL_REG6, seeded in begin() and kept in sync on every write
+  uint8_t _ctrlReg[6] = {0x07, 0x00, 0x00, 0x00, 0x00, 0x00};
+  uint8_t _ctrlDirty = 0;
+  uint8_t _configDepth = 0;
+
+  void setCtrlReg(uint8_t reg, uint8_t value);
+  void checkRecovery(void);
+  uint8_t getCtrlReg(uint8_t reg) { return _ctrlReg[reg - REG_CTRL_REG1]; }
+  void updateScale(void);
+  uint8_t thresholdToReg(uint8_t threshold);
 
   int16_t _accX, _accY, _accZ;
   int16_t _maxAccX, _maxAccY, _maxAccZ;
   int16_t _minAccX, _minAccY, _minAccZ;
 
 };
+
+/**
+ * @brief Compile-time raw to mg conversion for one range/mode pair.
+ * Output data is left-justified, mg = (raw >> shift) * mgPerDigit where shift drops the
+ * unused low bits (8/6/4 bits in low-power/normal/high-resolution mode) and mgPerDigit
+ * is the datasheet sensitivity. Both are constants, so no division is left.
+ */
+template <LIS2DH12::eRange_t RANGE, LIS2DH12::eResolutionMode_t MODE>
+struct LIS2DH12Scale
+{
+  static constexpr uint8_t shift = (MODE == LIS2DH12::HIGH_RESOLUTION_MODE) ? 4 :
+                                   (MODE == LIS2DH12::NORMAL_MODE) ? 6 : 8;
+
+  static constexpr int16_t mgPerDigit = ((RANGE == LIS2DH12::eLIS2DH12_2g) ? 1 :
+                                         (RANGE == LIS2DH12::eLIS2DH12_4g) ? 2 :
+                                         (RANGE == LIS2DH12::eLIS2DH12_8g) ? 4 : 12)
+                                        << (shift - 4);
+
+  static inline int16_t toMg(int16_t raw)
+  {
+  #if defined(__AVR__)
+    return -(int16_t)((raw >> shift) * mgPerDigit);
+  #else
+    return (int16_t)((raw >> shift) * mgPerDigit);
+  #endif
+  }
+
+  static void toMg(const int16_t* raw, int16_t* mg, size_t count)
+  {
+    for (size_t i = 0; i < count; i++) {
+      mg[i] = toMg(raw[i]);
+    }
+  }
+};
+
 #endif
\ No newline at end of file
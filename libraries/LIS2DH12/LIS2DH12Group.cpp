@@ -0,0 +1,77 @@
+#include "LIS2DH12Group.h"
+
+static uint32_t defaultClock(void)
+{
+#if defined(ARDUINO)
+  return micros();
+#else
+  return 0;
+#endif
+}
+
+LIS2DH12Group::LIS2DH12Group(LIS2DH12ClockFn clock)
+{
+  _clock = clock ? clock : defaultClock;
+  memset(_sampleCount, 0, sizeof(_sampleCount));
+  memset(_hasAnchor, 0, sizeof(_hasAnchor));
+}
+
+bool LIS2DH12Group::addDevice(LIS2DH12* device)
+{
+  if (device == NULL || _deviceCount >= LIS2DH12_GROUP_MAX_DEVICES) {
+    return false;
+  }
+  _devices[_deviceCount++] = device;
+  return true;
+}
+
+void LIS2DH12Group::setAnchor(uint8_t index, uint32_t timeUs, uint8_t sampleIndex)
+{
+  _hasAnchor[index] = true;
+  _anchorUs[index] = timeUs;
+  _anchorIndex[index] = sampleIndex;
+}
+
+void LIS2DH12Group::stampBlock(uint8_t index, uint32_t readTimeUs)
+{
+  uint16_t rate = _devices[index]->getAcquireRate();
+  uint32_t periodUs = rate ? 1000000UL / rate : 0;
+  if (periodUs != _clocks[index].getNominalPeriodUs()) {
+    _clocks[index].reset(periodUs);
+  }
+
+  uint8_t count = _sampleCount[index];
+  if (_hasAnchor[index] && _anchorIndex[index] < count) {
+    _clocks[index].stampBlock(_anchorUs[index], _anchorIndex[index], count);
+  } else if (count > 0) {
+    _clocks[index].stampBlock(readTimeUs, count - 1, count);
+  }
+  _hasAnchor[index] = false;
+}
+
+size_t LIS2DH12Group::drain(void)
+{
+  size_t total = 0;
+  for (uint8_t i = 0; i < _deviceCount; i++) {
+    _sampleCount[i] = _devices[i]->readFifo(_samples[i], LIS2DH12_FIFO_SIZE);
+    // Stamp each device separately, the previous burst took bus time
+    stampBlock(i, _clock());
+    total += _sampleCount[i];
+  }
+  return total;
+}
+
+bool LIS2DH12Group::readLatest(uint8_t index)
+{
+  _sampleCount[index] = 0;
+  if (!_devices[index]->isDataAvailable()) {
+    return false;
+  }
+  int16_t* xyz = _samples[index];
+  if (!_devices[index]->getAcceleration(&xyz[0], &xyz[1], &xyz[2])) {
+    return false;
+  }
+  _sampleCount[index] = 1;
+  stampBlock(index, _clock());
+  return true;
+}
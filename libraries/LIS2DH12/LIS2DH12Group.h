@@ -0,0 +1,109 @@
+#ifndef LIS2DH12_GROUP_H
+#define LIS2DH12_GROUP_H
+
+#include "LIS2DH12.h"
+#include "LIS2DH12SampleClock.h"
+
+#define LIS2DH12_GROUP_MAX_DEVICES 2   ///< e.g. one sensor per crank, or crank + frame
+
+typedef uint32_t (*LIS2DH12ClockFn)(void);
+
+/**
+ * @brief Several LIS2DH12 on one bus, drained as a batch.
+ * Every device runs its FIFO in stream mode; drain() reads them back to back and
+ * reconstructs per-sample timestamps on a common time base with one
+ * LIS2DH12SampleClock per device.
+ */
+class LIS2DH12Group
+{
+public:
+  /**
+   * @fn LIS2DH12Group
+   * @param clock Microsecond clock used to stamp drained blocks, micros() on Arduino when NULL
+   */
+  LIS2DH12Group(LIS2DH12ClockFn clock = NULL);
+
+  /**
+   * @fn addDevice
+   * @brief Add a sensor to the group
+   * @return false if the group is full
+   */
+  bool addDevice(LIS2DH12* device);
+
+  uint8_t getDeviceCount(void) const { return _deviceCount; }
+
+  /**
+   * @fn now
+   * @brief Current time on the group's clock (us), the time base of all sample timestamps
+   */
+  uint32_t now(void) const { return _clock(); }
+  LIS2DH12* getDevice(uint8_t index) { return _devices[index]; }
+
+  /**
+   * @fn setAnchor
+   * @brief Provide the production time of one sample of the next block of a device
+   * @param index Device index
+   * @param timeUs INT1 time captured by the ISR
+   * @param sampleIndex Position of that sample in the next block (the FIFO watermark for a
+   *        watermark interrupt, 0 for data-ready)
+   * @details Without an anchor the newest sample of a block is taken as produced at read time.
+   */
+  void setAnchor(uint8_t index, uint32_t timeUs, uint8_t sampleIndex);
+
+  /**
+   * @fn drain
+   * @brief Read every device's FIFO, one burst per device, back to back
+   * @return Total number of samples read
+   */
+  size_t drain(void);
+
+  /**
+   * @fn readLatest
+   * @brief Poll one device without FIFO: read its output registers if STATUS reports new data
+   * @return true if a sample was read, it is then the only sample of the device's block
+   */
+  bool readLatest(uint8_t index);
+
+  /**
+   * @fn getSampleCount
+   * @brief Number of samples read from a device by the last drain()
+   */
+  uint8_t getSampleCount(uint8_t index) const { return _sampleCount[index]; }
+
+  /**
+   * @fn getSamples
+   * @brief Raw interleaved samples (x0, y0, z0, x1, ...) read from a device by the last drain()
+   */
+  const int16_t* getSamples(uint8_t index) const { return _samples[index]; }
+
+  /**
+   * @fn getSampleTime
+   * @brief Reconstructed timestamp (us) of one sample of the last block
+   */
+  uint32_t getSampleTime(uint8_t index, uint8_t sample) const
+  {
+    return _clocks[index].getSampleTime(sample);
+  }
+
+  /**
+   * @fn getLostSamples
+   * @brief Samples of a device estimated lost from timestamp gaps
+   */
+  uint32_t getLostSamples(uint8_t index) const { return _clocks[index].getLostSamples(); }
+
+private:
+  LIS2DH12ClockFn _clock;
+  LIS2DH12* _devices[LIS2DH12_GROUP_MAX_DEVICES];
+  uint8_t _deviceCount = 0;
+
+  int16_t _samples[LIS2DH12_GROUP_MAX_DEVICES][LIS2DH12_FIFO_SIZE * 3];
+  uint8_t _sampleCount[LIS2DH12_GROUP_MAX_DEVICES];
+  LIS2DH12SampleClock _clocks[LIS2DH12_GROUP_MAX_DEVICES];
+  bool _hasAnchor[LIS2DH12_GROUP_MAX_DEVICES];
+  uint32_t _anchorUs[LIS2DH12_GROUP_MAX_DEVICES];
+  uint8_t _anchorIndex[LIS2DH12_GROUP_MAX_DEVICES];
+
+  void stampBlock(uint8_t index, uint32_t readTimeUs);
+};
+
+#endif
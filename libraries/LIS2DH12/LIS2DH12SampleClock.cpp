@@ -0,0 +1,55 @@
+#include "LIS2DH12SampleClock.h"
+
+void LIS2DH12SampleClock::reset(uint32_t nominalPeriodUs)
+{
+  _nominalQ8 = nominalPeriodUs << 8;
+  _periodQ8 = _nominalQ8;
+  _locked = false;
+}
+
+void LIS2DH12SampleClock::anchor(uint32_t anchorUs, uint8_t anchorIndex)
+{
+  _blockStartQ8 = ((uint64_t)anchorUs << 8) - (uint64_t)anchorIndex * _periodQ8;
+  _locked = true;
+}
+
+void LIS2DH12SampleClock::stampBlock(uint32_t anchorUs, uint8_t anchorIndex, uint8_t count)
+{
+  if (count == 0) {
+    return;
+  }
+
+  if (!_locked) {
+    anchor(anchorUs, anchorIndex);
+  } else {
+    uint32_t predictedUs = (uint32_t)((_nextQ8 + (uint64_t)anchorIndex * _periodQ8) >> 8);
+    int32_t error = (int32_t)(anchorUs - predictedUs);
+    int32_t periodUs = (int32_t)(_periodQ8 >> 8);
+
+    if (error > 2 * periodUs) {
+      // Samples were overwritten before we read them
+      _lostSamples += error / periodUs;
+      anchor(anchorUs, anchorIndex);
+    } else if (error < -2 * periodUs) {
+      anchor(anchorUs, anchorIndex);
+    } else {
+      // Move a quarter of the phase error now, and an eighth of it into the period
+      uint16_t span = _sinceAnchor + anchorIndex;
+      if (span == 0) {
+        span = 1;
+      }
+      _blockStartQ8 = _nextQ8 + (int64_t)error * 64;
+      int64_t period = (int64_t)_periodQ8 + ((int64_t)error * 32) / span;
+
+      // The datasheet ODR tolerance is well inside +/-25 %
+      int64_t minPeriod = _nominalQ8 - (_nominalQ8 >> 2);
+      int64_t maxPeriod = _nominalQ8 + (_nominalQ8 >> 2);
+      if (period < minPeriod) period = minPeriod;
+      if (period > maxPeriod) period = maxPeriod;
+      _periodQ8 = (uint32_t)period;
+    }
+  }
+
+  _nextQ8 = _blockStartQ8 + (uint64_t)count * _periodQ8;
+  _sinceAnchor = count - anchorIndex;
+}
@@ -0,0 +1,71 @@
+#ifndef LIS2DH12_SAMPLE_CLOCK_H
+#define LIS2DH12_SAMPLE_CLOCK_H
+
+#include "LIS2DH12Transport.h"
+
+/**
+ * @brief Reconstructs per-sample timestamps for blocks read from one LIS2DH12.
+ * @details The sensor's internal oscillator can be several percent off its nominal ODR,
+ *          so timestamps are extrapolated with a tracked period rather than the nominal one.
+ *          Each block carries one anchor: the time a given sample in the block was known to
+ *          be produced (INT1 watermark/DRDY time from the ISR, or the read time otherwise).
+ *          The difference between the predicted and measured anchor corrects the phase and,
+ *          spread over the samples since the previous anchor, the period.
+ *          A jump of more than two periods means samples were lost (FIFO overrun, long stall)
+ *          and the clock re-anchors.
+ */
+class LIS2DH12SampleClock
+{
+public:
+  /**
+   * @fn reset
+   * @brief Forget the tracked phase and period, e.g. after an ODR change
+   * @param nominalPeriodUs Configured sample period
+   */
+  void reset(uint32_t nominalPeriodUs);
+
+  /**
+   * @fn stampBlock
+   * @brief Assign timestamps to a block of consecutive samples
+   * @param anchorUs Time sample anchorIndex of this block was produced
+   * @param anchorIndex Index of the anchored sample within the block
+   * @param count Number of samples in the block
+   */
+  void stampBlock(uint32_t anchorUs, uint8_t anchorIndex, uint8_t count);
+
+  /**
+   * @fn getSampleTime
+   * @brief Timestamp (us) of a sample of the last stamped block
+   */
+  uint32_t getSampleTime(uint8_t sample) const
+  {
+    return (uint32_t)((_blockStartQ8 + (uint64_t)sample * _periodQ8) >> 8);
+  }
+
+  uint32_t getNominalPeriodUs(void) const { return _nominalQ8 >> 8; }
+
+  /**
+   * @fn getPeriodQ8
+   * @brief Tracked sample period, in 1/256 us
+   */
+  uint32_t getPeriodQ8(void) const { return _periodQ8; }
+
+  /**
+   * @fn getLostSamples
+   * @brief Samples estimated missing from timestamp gaps since the last reset
+   */
+  uint32_t getLostSamples(void) const { return _lostSamples; }
+
+private:
+  uint32_t _nominalQ8 = 0;
+  uint32_t _periodQ8 = 0;
+  uint64_t _blockStartQ8 = 0;
+  uint64_t _nextQ8 = 0;
+  uint16_t _sinceAnchor = 0;
+  bool _locked = false;
+  uint32_t _lostSamples = 0;
+
+  void anchor(uint32_t anchorUs, uint8_t anchorIndex);
+};
+
+#endif
@@ -0,0 +1,346 @@
+#include "LIS2DH12.h"
+
+size_t LIS2DH12Transport::readReg(uint8_t reg, void* pBuf, size_t size)
+{
+  uint32_t startUs = LIS2DH12_MICROS();
+  size_t n = read(reg, pBuf, size);
+  account(startUs, n, n == size);
+  return n;
+}
+
+bool LIS2DH12Transport::writeReg(uint8_t reg, const void* pBuf, size_t size)
+{
+  uint32_t startUs = LIS2DH12_MICROS();
+  bool ok = write(reg, pBuf, size);
+  account(startUs, ok ? size : 0, ok);
+  return ok;
+}
+
+void LIS2DH12Transport::account(uint32_t startUs, size_t size, bool ok)
+{
+  uint32_t latencyUs = LIS2DH12_MICROS() - startUs;
+  _stats.transactions++;
+  _stats.bytes += size + 1;
+  _stats.totalLatencyUs += latencyUs;
+  if (latencyUs > _stats.maxLatencyUs) {
+    _stats.maxLatencyUs = latencyUs;
+  }
+  if (!ok) {
+    _stats.failures++;
+  }
+}
+
+#if defined(ARDUINO)
+
+LIS2DH12I2C::LIS2DH12I2C(TwoWire* pWire, uint8_t addr, uint32_t clock)
+{
+  _pWire = pWire;
+  _deviceAddr = addr;
+  _clock = clock;
+#if defined(ESP32)
+  _sdaPin = SDA;
+  _sclPin = SCL;
+#endif
+}
+
+void LIS2DH12I2C::begin(void)
+{
+  if (_sdaPin >= 0 && _sclPin >= 0) {
+    _pWire->begin(_sdaPin, _sclPin);
+  } else {
+    _pWire->begin();
+  }
+  _pWire->setClock(_clock);
+  _pWire->setTimeOut(LIS2DH12_I2C_TIMEOUT_MS);
+}
+
+void LIS2DH12I2C::setClock(uint32_t hz)
+{
+  // The LIS2DH12 is specified up to 400 kHz; 1 MHz works on short traces but is out of spec
+  _clock = hz;
+  _pWire->setClock(_clock);
+}
+
+void LIS2DH12I2C::setPins(int sdaPin, int sclPin)
+{
+  _sdaPin = sdaPin;
+  _sclPin = sclPin;
+}
+
+void LIS2DH12I2C::onResult(bool ok)
+{
+  if (ok) {
+    _consecutiveFailures = 0;
+    return;
+  }
+  if (++_consecutiveFailures >= LIS2DH12_I2C_RECOVERY_THRESHOLD) {
+    recoverBus();
+  }
+}
+
+void LIS2DH12I2C::recoverBus(void)
+{
+  DBG("I2C bus recovery");
+  _consecutiveFailures = 0;
+  _pWire->end();
+  if (_sdaPin >= 0 && _sclPin >= 0) {
+    uint32_t halfPeriodUs = 5;   // ~100 kHz
+    pinMode(_sdaPin, INPUT_PULLUP);
+    pinMode(_sclPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(_sclPin, HIGH);
+    // A slave stuck mid-byte releases SDA after at most 9 clocks
+    for (uint8_t i = 0; i < 9 && digitalRead(_sdaPin) == LOW; i++) {
+      digitalWrite(_sclPin, LOW);
+      delayMicroseconds(halfPeriodUs);
+      digitalWrite(_sclPin, HIGH);
+      delayMicroseconds(halfPeriodUs);
+    }
+    // STOP: SDA low -> high while SCL is high
+    pinMode(_sdaPin, OUTPUT_OPEN_DRAIN);
+    digitalWrite(_sdaPin, LOW);
+    delayMicroseconds(halfPeriodUs);
+    digitalWrite(_sclPin, HIGH);
+    delayMicroseconds(halfPeriodUs);
+    digitalWrite(_sdaPin, HIGH);
+    delayMicroseconds(halfPeriodUs);
+  }
+  begin();
+  _stats.recoveries++;
+}
+
+bool LIS2DH12I2C::write(uint8_t reg, const void * pBuf, size_t size)
+{
+  if(pBuf == NULL){
+    DBG("pBuf ERROR!! : null pointer");
+    return false;
+  }
+  uint8_t * _pBuf = (uint8_t *)pBuf;
+  _pWire->beginTransmission(_deviceAddr);
+  _pWire->write(&reg, 1);
+
+  for(uint16_t i = 0; i < size; i++){
+    _pWire->write(_pBuf[i]);
+  }
+  bool ok = _pWire->endTransmission() == 0;
+  onResult(ok);
+  return ok;
+}
+
+size_t LIS2DH12I2C::read(uint8_t reg, void* pBuf, size_t size)
+{
+  if(pBuf == NULL){
+    DBG("pBuf ERROR!! : null pointer");
+    return 0;
+  }
+  uint8_t * _pBuf = (uint8_t *)pBuf;
+  _pWire->beginTransmission(_deviceAddr);
+  _pWire->write(&reg, 1);
+  if( _pWire->endTransmission(false) != 0){
+    onResult(false);
+    return 0;
+  }
+  // A NACK or timeout shows up as a short read; never hand back a partially filled buffer
+  if (_pWire->requestFrom(_deviceAddr, (uint8_t) size) != size) {
+    while (_pWire->available()) {
+      _pWire->read();
+    }
+    onResult(false);
+    return 0;
+  }
+  for(uint16_t i = 0; i < size; i++){
+    _pBuf[i] = _pWire->read();
+  }
+  onResult(true);
+  return size;
+}
+
+size_t LIS2DH12I2C::maxReadSize(void)
+{
+  // requestFrom() is limited by the Wire receive buffer
+#if defined(I2C_BUFFER_LENGTH)
+  return I2C_BUFFER_LENGTH;
+#elif defined(BUFFER_LENGTH)
+  return BUFFER_LENGTH;
+#else
+  return 32;
+#endif
+}
+
+LIS2DH12SPI::LIS2DH12SPI(SPIClass* pSpi, uint8_t csPin, uint32_t clock)
+  : _pSpi(pSpi), _csPin(csPin), _settings(clock, MSBFIRST, SPI_MODE3)
+{
+}
+
+void LIS2DH12SPI::begin(void)
+{
+  pinMode(_csPin, OUTPUT);
+  digitalWrite(_csPin, HIGH);
+  _pSpi->begin();
+}
+
+void LIS2DH12SPI::setClock(uint32_t hz)
+{
+  _settings = SPISettings(hz, MSBFIRST, SPI_MODE3);
+}
+
+size_t LIS2DH12SPI::read(uint8_t reg, void* pBuf, size_t size)
+{
+  if(pBuf == NULL){
+    DBG("pBuf ERROR!! : null pointer");
+    return 0;
+  }
+  // SPI framing: bit 7 = read, bit 6 = auto-increment (MS), bits 5..0 = address
+  uint8_t command = 0x80 | (reg & 0x3F);
+  if (reg & 0x80) {
+    command |= 0x40;
+  }
+
+  _pSpi->beginTransaction(_settings);
+  digitalWrite(_csPin, LOW);
+  _pSpi->transfer(command);
+  memset(pBuf, 0, size);
+  _pSpi->transfer(pBuf, size);
+  digitalWrite(_csPin, HIGH);
+  _pSpi->endTransaction();
+  return size;
+}
+
+bool LIS2DH12SPI::write(uint8_t reg, const void* pBuf, size_t size)
+{
+  if(pBuf == NULL){
+    DBG("pBuf ERROR!! : null pointer");
+    return false;
+  }
+  uint8_t command = reg & 0x3F;
+  if (reg & 0x80) {
+    command |= 0x40;
+  }
+
+  _pSpi->beginTransaction(_settings);
+  digitalWrite(_csPin, LOW);
+  _pSpi->transfer(command);
+  _pSpi->writeBytes((const uint8_t*)pBuf, size);
+  digitalWrite(_csPin, HIGH);
+  _pSpi->endTransaction();
+  return true;
+}
+
+size_t LIS2DH12SPI::maxReadSize(void)
+{
+  return LIS2DH12_FIFO_SIZE * 6;
+}
+
+#endif
+
+LIS2DH12RegisterFile::LIS2DH12RegisterFile()
+{
+  memset(_regs, 0, sizeof(_regs));
+  memset(_samples, 0, sizeof(_samples));
+  _regs[REG_CARD_ID] = 0x33;
+  _regs[REG_CTRL_REG1] = 0x07;
+}
+
+uint8_t LIS2DH12RegisterFile::fifoDepth(void) const
+{
+  bool fifoEnabled = (_regs[REG_CTRL_REG5] & 0x40) && (_regs[REG_FIFO_CTRL_REG] & 0xC0);
+  return fifoEnabled ? LIS2DH12_FIFO_SIZE : 1;
+}
+
+void LIS2DH12RegisterFile::pushSample(int16_t x, int16_t y, int16_t z)
+{
+  if (_count >= fifoDepth()) {
+    _overrun = true;
+    // FIFO mode stops collecting when full, bypass and stream overwrite the oldest sample
+    if (fifoDepth() > 1 && (_regs[REG_FIFO_CTRL_REG] & 0xC0) == LIS2DH12::eFIFO_Fifo) {
+      return;
+    }
+    _head = (_head + 1) % LIS2DH12_FIFO_SIZE;
+    _count--;
+  }
+  int16_t* slot = _samples[(_head + _count) % LIS2DH12_FIFO_SIZE];
+  slot[0] = x;
+  slot[1] = y;
+  slot[2] = z;
+  _count++;
+}
+
+uint8_t LIS2DH12RegisterFile::readOne(uint8_t addr)
+{
+  switch (addr) {
+    case REG_STATUS_REG:
+      return (_count ? 0x0F : 0x00) | (_overrun ? 0xF0 : 0x00);
+
+    case REG_FIFO_SRC_REG: {
+      uint8_t src = _count & 0x1F;
+      if (_count > (_regs[REG_FIFO_CTRL_REG] & 0x1F)) src |= 0x80;  // WTM
+      if (_count == LIS2DH12_FIFO_SIZE) src |= 0x40;               // OVRN_FIFO
+      if (_count == 0) src |= 0x20;                                // EMPTY
+      return src;
+    }
+
+    case REG_OUT_X_L: case REG_OUT_X_H:
+    case REG_OUT_Y_L: case REG_OUT_Y_H:
+    case REG_OUT_Z_L: case REG_OUT_Z_H:
+      if (_count > 0) {
+        uint16_t value = (uint16_t)_samples[_head][(addr - REG_OUT_X_L) >> 1];
+        _regs[addr] = (addr & 1) ? (uint8_t)(value >> 8) : (uint8_t)value;
+        // Reading OUT_Z_H releases the sample
+        if (addr == REG_OUT_Z_H) {
+          _head = (_head + 1) % LIS2DH12_FIFO_SIZE;
+          _count--;
+          if (fifoDepth() == 1) _overrun = false;
+        }
+      }
+      return _regs[addr];
+
+    default:
+      return _regs[addr];
+  }
+}
+
+size_t LIS2DH12RegisterFile::read(uint8_t reg, void* pBuf, size_t size)
+{
+  if (pBuf == NULL) {
+    return 0;
+  }
+  uint8_t* _pBuf = (uint8_t*)pBuf;
+  uint8_t addr = reg & 0x3F;  // The map ends at 0x3F; bit 6 is the SPI auto-increment flag
+  bool autoIncrement = (reg & 0x80) != 0;
+
+  for (size_t i = 0; i < size; i++) {
+    _pBuf[i] = readOne(addr);
+    if (autoIncrement) {
+      // With the FIFO enabled the output address wraps back to OUT_X_L
+      if (addr == REG_OUT_Z_H && fifoDepth() > 1) {
+        addr = REG_OUT_X_L;
+      } else {
+        addr = (addr + 1) & 0x3F;
+      }
+    }
+  }
+  return size;
+}
+
+bool LIS2DH12RegisterFile::write(uint8_t reg, const void* pBuf, size_t size)
+{
+  if (pBuf == NULL) {
+    return false;
+  }
+  const uint8_t* _pBuf = (const uint8_t*)pBuf;
+  uint8_t addr = reg & 0x3F;
+  bool autoIncrement = (reg & 0x80) != 0;
+
+  for (size_t i = 0; i < size; i++) {
+    _regs[addr] = _pBuf[i];
+    // Bypass mode empties the FIFO
+    if (addr == REG_FIFO_CTRL_REG && (_pBuf[i] & 0xC0) == 0) {
+      _head = 0;
+      _count = 0;
+      _overrun = false;
+    }
+    if (autoIncrement) {
+      addr = (addr + 1) & 0x3F;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,214 @@
+#ifndef LIS2DH12_TRANSPORT_H
+#define LIS2DH12_TRANSPORT_H
+
+#if defined(ARDUINO)
+#include "Arduino.h"
+#include <Wire.h>
+#include <SPI.h>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+#define LIS2DH12_SPI_CLOCK 10000000   ///< Maximum SPI clock of the LIS2DH12 (10 MHz)
+#define LIS2DH12_I2C_CLOCK 400000     ///< I2C fast mode
+#define LIS2DH12_I2C_TIMEOUT_MS 10    ///< Upper bound on a stuck I2C transaction
+#define LIS2DH12_I2C_RECOVERY_THRESHOLD 3   ///< Consecutive failures before the bus is recovered
+
+#if defined(ARDUINO)
+#define LIS2DH12_MICROS() ((uint32_t)micros())
+#else
+#define LIS2DH12_MICROS() ((uint32_t)0)
+#endif
+
+/**
+ * @brief Bus usage counters, see LIS2DH12Transport::getStats()
+ */
+typedef struct{
+  uint32_t transactions;   /**<Read and write transactions>*/
+  uint32_t bytes;          /**<Bytes on the bus, register address included>*/
+  uint32_t failures;       /**<NACKs, short reads and timeouts>*/
+  uint32_t recoveries;     /**<Bus recoveries performed>*/
+  uint32_t totalLatencyUs; /**<Time spent in transactions>*/
+  uint32_t maxLatencyUs;   /**<Slowest single transaction>*/
+}sLIS2DH12BusStats_t;
+
+/**
+ * @brief Register access used by LIS2DH12.
+ * Register addresses follow the I2C sub-address convention: bit 7 set requests
+ * auto-increment for multi-byte accesses. Each backend maps that to its own framing.
+ * readReg()/writeReg() time and count every transaction; backends implement read()/write().
+ */
+class LIS2DH12Transport
+{
+public:
+  LIS2DH12Transport() { resetStats(); }
+  virtual ~LIS2DH12Transport() {}
+
+  /**
+   * @fn begin
+   * @brief Initialise the underlying bus
+   */
+  virtual void begin(void) = 0;
+
+  /**
+   * @fn setClock
+   * @brief Set the bus clock (Hz), takes effect immediately and on the next begin()
+   */
+  virtual void setClock(uint32_t hz) { (void)hz; }
+
+  /**
+   * @fn readReg
+   * @brief read data from sensor chip register
+   * @param reg chip register, bit 7 set for auto-increment
+   * @param pBuf  buf for store data to read
+   * @param size  number of data to read
+   * @return The number of successfully read data, 0 on a bus error
+   */
+  size_t readReg(uint8_t reg, void* pBuf, size_t size);
+
+  /**
+   * @fn writeReg
+   * @brief Write data to sensor register
+   * @param reg register, bit 7 set for auto-increment
+   * @param pBuf  buf for store data to write
+   * @param size  The number of the data in pBuf
+   * @return true(Succeed)/false(Failed)
+   */
+  bool writeReg(uint8_t reg, const void* pBuf, size_t size);
+
+  /**
+   * @fn maxReadSize
+   * @brief Largest read the backend can do in one transaction
+   */
+  virtual size_t maxReadSize(void) = 0;
+
+  /**
+   * @fn getStats
+   * @brief Transaction, byte, failure and latency counters since the last resetStats()
+   */
+  const sLIS2DH12BusStats_t& getStats(void) const { return _stats; }
+
+  void resetStats(void) { memset(&_stats, 0, sizeof(_stats)); }
+
+protected:
+  virtual size_t read(uint8_t reg, void* pBuf, size_t size) = 0;
+  virtual bool write(uint8_t reg, const void* pBuf, size_t size) = 0;
+
+  sLIS2DH12BusStats_t _stats;
+
+private:
+  void account(uint32_t startUs, size_t size, bool ok);
+};
+
+#if defined(ARDUINO)
+/**
+ * @brief I2C backend on an Arduino TwoWire controller
+ */
+class LIS2DH12I2C : public LIS2DH12Transport
+{
+public:
+  LIS2DH12I2C(TwoWire* pWire, uint8_t addr, uint32_t clock = LIS2DH12_I2C_CLOCK);
+
+  void begin(void) override;
+  void setClock(uint32_t hz) override;
+  size_t maxReadSize(void) override;
+
+  /**
+   * @fn setPins
+   * @brief SDA/SCL pins, needed to clock a stuck bus free (board defaults on ESP32)
+   */
+  void setPins(int sdaPin, int sclPin);
+
+  /**
+   * @fn recoverBus
+   * @brief Release a slave holding SDA low: up to 9 SCL pulses, a STOP, then re-init Wire
+   * @details Called automatically after LIS2DH12_I2C_RECOVERY_THRESHOLD consecutive failures.
+   */
+  void recoverBus(void);
+
+protected:
+  size_t read(uint8_t reg, void* pBuf, size_t size) override;
+  bool write(uint8_t reg, const void* pBuf, size_t size) override;
+
+private:
+  TwoWire* _pWire;
+  uint8_t _deviceAddr;
+  uint32_t _clock;
+  int _sdaPin = -1;
+  int _sclPin = -1;
+  uint8_t _consecutiveFailures = 0;
+
+  void onResult(bool ok);
+};
+
+/**
+ * @brief 4-wire SPI backend, up to 10 MHz
+ * @details No receive-buffer limit, so a full 32-sample FIFO is drained in one transaction.
+ */
+class LIS2DH12SPI : public LIS2DH12Transport
+{
+public:
+  LIS2DH12SPI(SPIClass* pSpi, uint8_t csPin, uint32_t clock = LIS2DH12_SPI_CLOCK);
+
+  void begin(void) override;
+  void setClock(uint32_t hz) override;
+  size_t maxReadSize(void) override;
+
+protected:
+  size_t read(uint8_t reg, void* pBuf, size_t size) override;
+  bool write(uint8_t reg, const void* pBuf, size_t size) override;
+
+private:
+  SPIClass* _pSpi;
+  uint8_t _csPin;
+  SPISettings _settings;
+};
+#endif
+
+/**
+ * @brief In-memory register file emulating the LIS2DH12, for host builds without hardware.
+ * @details Samples queued with pushSample() are served through OUT_X_L..OUT_Z_H, STATUS_REG
+ *          and FIFO_SRC_REG the way the chip does in bypass, FIFO and stream mode, including
+ *          the OUT_Z_H -> OUT_X_L address wrap when the FIFO is enabled.
+ */
+class LIS2DH12RegisterFile : public LIS2DH12Transport
+{
+public:
+  LIS2DH12RegisterFile();
+
+  void begin(void) override {}
+  size_t maxReadSize(void) override { return 0xFFFF; }
+
+  /**
+   * @fn pushSample
+   * @brief Make a new raw sample available, as if the chip had just converted it
+   */
+  void pushSample(int16_t x, int16_t y, int16_t z);
+
+  /**
+   * @fn getQueued
+   * @brief Number of samples not yet read
+   */
+  uint8_t getQueued(void) const { return _count; }
+
+  uint8_t getRegister(uint8_t reg) const { return _regs[reg & 0x3F]; }
+  void setRegister(uint8_t reg, uint8_t value) { _regs[reg & 0x3F] = value; }
+
+protected:
+  size_t read(uint8_t reg, void* pBuf, size_t size) override;
+  bool write(uint8_t reg, const void* pBuf, size_t size) override;
+
+private:
+  uint8_t _regs[0x40];
+  int16_t _samples[32][3];
+  uint8_t _head = 0;
+  uint8_t _count = 0;
+  bool _overrun = false;
+
+  uint8_t readOne(uint8_t addr);
+  uint8_t fifoDepth(void) const;
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef CADENCE_ESTIMATOR_H
+#define CADENCE_ESTIMATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "SlidingMinMax.h"
+#include "StepFilter.h"
+
+// Cadence from the periodicity of the signal rather than from threshold crossings.
+// Samples are decimated to about Config::cadenceRateHz and DC-blocked. A sliding autocorrelation
+// over the last Config::cadenceWindow decimated samples is updated exactly, in integers: each new
+// sample adds one product per lag and the sample leaving the window removes one. The cadence is
+// the shortest strong peak between the lags of Config::minStepInterval and Config::maxStepInterval.
+// Cost per decimated sample is two multiply-adds per lag plus the peak search.
+// Only built with Config::spectralCadence; otherwise the empty specialization below stands in.
+template <class Config, bool ENABLED = Config::spectralCadence>
+class CadenceEstimator {
+public:
+  static constexpr uint16_t window = Config::cadenceWindow;
+  static constexpr uint16_t minLag = (uint32_t)Config::minStepInterval * Config::cadenceRateHz / 1000;
+  static constexpr uint16_t maxLag = (uint32_t)Config::maxStepInterval * Config::cadenceRateHz / 1000;
+  static constexpr uint16_t ringSize = window + maxLag + 2;
+
+  static_assert(minLag >= 2, "cadenceRateHz too low for minStepInterval");
+  static_assert(window >= 2 * maxLag, "cadenceWindow must hold two periods at the slowest cadence");
+
+  CadenceEstimator() { configure(Config::cadenceRateHz); }
+
+  // Sets the decimation for the sensor rate and clears the history
+  void configure(uint16_t sampleRateHz) {
+    decimation = sampleRateHz > Config::cadenceRateHz ? sampleRateHz / Config::cadenceRateHz : 1;
+    decimatedRateHz = sampleRateHz / decimation;
+    reset();
+  }
+
+  void reset() {
+    head = 0;
+    count = 0;
+    decimationSum = 0;
+    decimationCount = 0;
+    dcBlocker.reset();
+    memset(corr, 0, sizeof(corr));
+    intervalQ8 = 0;
+    confidenceQ8 = 0;
+  }
+
+  void process(const int16_t* v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      decimationSum += v[i];
+      if (++decimationCount < decimation) continue;
+      int16_t sample = (int16_t)(decimationSum / decimation);
+      decimationSum = 0;
+      decimationCount = 0;
+      dcBlocker.process(&sample, 1);
+      // +-2047 keeps a full window of products inside int32
+      push(saturate(sample >> 2));
+    }
+  }
+
+  // Average pedal interval in ms, Q8; 0 until there is an estimate
+  uint32_t getIntervalQ8() const { return intervalQ8; }
+  // Autocorrelation at the chosen lag relative to lag 0, 0..256
+  uint16_t getConfidenceQ8() const { return confidenceQ8; }
+
+private:
+  int16_t ring[ringSize];
+  int32_t corr[maxLag + 2];   // corr[k] = sum over the window of x[n] * x[n - k]
+  uint16_t head;              // Slot of the newest sample
+  uint32_t count;             // Decimated samples since reset
+  int32_t decimationSum;
+  uint16_t decimationCount;
+  uint16_t decimation;
+  uint16_t decimatedRateHz;
+  DcBlocker<5> dcBlocker;
+  uint32_t intervalQ8;
+  uint16_t confidenceQ8;
+
+  static int16_t saturate(int16_t v) { return v > 2047 ? 2047 : (v < -2047 ? -2047 : v); }
+
+  int16_t at(uint32_t age) const {
+    // Sample from `age` decimated samples ago
+    return ring[(head + ringSize - age) % ringSize];
+  }
+
+  void push(int16_t x) {
+    head = ringNext<ringSize>(head);
+    ring[head] = x;
+    count++;
+
+    bool leaving = count > window;
+    int16_t old = leaving ? at(window) : 0;
+    for (uint16_t k = 0; k <= maxLag + 1; k++) {
+      if (k != 0 && k + 1 < minLag) continue;
+      if (count > k) corr[k] += (int32_t)x * at(k);
+      if (leaving && count > (uint32_t)window + k) corr[k] -= (int32_t)old * at(window + k);
+    }
+    estimate();
+  }
+
+  void estimate() {
+    // Wait for half a window, and only trust lags that fit twice into what has been seen
+    uint32_t seen = count < window ? count : window;
+    uint16_t lastLag = seen / 2 < maxLag ? seen / 2 : maxLag;
+    if (count < window / 2 || lastLag <= minLag || corr[0] <= 0) {
+      intervalQ8 = 0;
+      confidenceQ8 = 0;
+      return;
+    }
+
+    int32_t best = 0;
+    for (uint16_t k = minLag; k <= lastLag; k++) {
+      if (corr[k] > best) best = corr[k];
+    }
+    if (best <= 0) {
+      intervalQ8 = 0;
+      confidenceQ8 = 0;
+      return;
+    }
+
+    // The shortest local peak close to the best one, so a multiple of the period is not picked
+    uint16_t lag = 0;
+    for (uint16_t k = minLag; k <= lastLag; k++) {
+      if (corr[k] >= corr[k - 1] && corr[k] >= corr[k + 1] && corr[k] >= best - best / 8) {
+        lag = k;
+        break;
+      }
+    }
+    if (lag == 0) {
+      intervalQ8 = 0;
+      confidenceQ8 = 0;
+      return;
+    }
+
+    // Parabolic interpolation between the neighbouring lags, offset in Q8 of a lag
+    int64_t left = corr[lag - 1], centre = corr[lag], right = corr[lag + 1];
+    int64_t curvature = left - 2 * centre + right;
+    int32_t offsetQ8 = curvature < 0 ? (int32_t)((left - right) * 128 / curvature) : 0;
+    int32_t lagQ8 = ((int32_t)lag << 8) + offsetQ8;
+
+    intervalQ8 = (uint32_t)((int64_t)lagQ8 * 1000 / decimatedRateHz);
+    int32_t confidence = (int32_t)((int64_t)centre * 256 / corr[0]);
+    confidenceQ8 = confidence < 0 ? 0 : (confidence > 256 ? 256 : confidence);
+  }
+};
+
+template <class Config>
+class CadenceEstimator<Config, false> {
+public:
+  void configure(uint16_t) {}
+  void reset() {}
+  void process(const int16_t*, size_t) {}
+  uint32_t getIntervalQ8() const { return 0; }
+  uint16_t getConfidenceQ8() const { return 0; }
+};
+
+#endif
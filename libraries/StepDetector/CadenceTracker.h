@@ -0,0 +1,76 @@
+#ifndef CADENCE_TRACKER_H
+#define CADENCE_TRACKER_H
+
+#include <stdint.h>
+
+// Alpha-beta tracker of cadence (rpm, Q8) and its rate of change (rpm/s, Q8).
+// Every step interval corrects the state; between steps predict() extrapolates the trend,
+// bounded by the cadence the time since the last step still allows, so a rider who stops
+// pedalling fades out within one stroke instead of after the idle timeout.
+template <class Config>
+class CadenceTracker {
+public:
+  CadenceTracker() { reset(); }
+
+  void reset() {
+    valid = false;
+    cadenceQ8 = 0;
+    rateQ8 = 0;
+    lastUs = 0;
+  }
+
+  void update(uint32_t intervalMs, uint32_t timestampUs) {
+    if (intervalMs == 0) return;
+    int32_t measured = (int32_t)((60000UL << 8) / intervalMs);
+    if (!valid) {
+      // The first interval is the estimate, no need to wait for a full average
+      cadenceQ8 = measured;
+      rateQ8 = 0;
+      lastUs = timestampUs;
+      valid = true;
+      return;
+    }
+
+    int32_t dtMs = (int32_t)(timestampUs - lastUs) / 1000;
+    if (dtMs < 1) dtMs = 1;
+    int32_t predicted = cadenceQ8 + (int32_t)((int64_t)rateQ8 * dtMs / 1000);
+    int32_t residual = measured - predicted;
+
+    cadenceQ8 = predicted + ((residual * Config::trackerAlphaQ8) >> 8);
+    if (cadenceQ8 < 0) cadenceQ8 = 0;
+    rateQ8 += (int32_t)((int64_t)residual * Config::trackerBetaQ8 * 1000 / ((int64_t)dtMs << 8));
+    const int32_t maxRateQ8 = (int32_t)Config::trackerMaxRateRpmPerS << 8;
+    if (rateQ8 > maxRateQ8) rateQ8 = maxRateQ8;
+    if (rateQ8 < -maxRateQ8) rateQ8 = -maxRateQ8;
+    lastUs = timestampUs;
+  }
+
+  // Cadence in rpm Q8 expected at timestampUs (same clock as the step timestamps)
+  int32_t predictQ8(uint32_t timestampUs) const {
+    if (!valid) return 0;
+    int32_t elapsedMs = (int32_t)(timestampUs - lastUs) / 1000;
+    if (elapsedMs < 0) elapsedMs = 0;
+
+    // Follow the trend for at most one stroke, beyond that it is a guess
+    int32_t strokeMs = cadenceQ8 > 0 ? (int32_t)((60000UL << 8) / (uint32_t)cadenceQ8) : 0;
+    int32_t horizonMs = elapsedMs < strokeMs ? elapsedMs : strokeMs;
+    int32_t cadence = cadenceQ8 + (int32_t)((int64_t)rateQ8 * horizonMs / 1000);
+
+    // No step for elapsedMs means at most one revolution in that time
+    if (elapsedMs > 0) {
+      int32_t boundQ8 = (int32_t)((60000UL << 8) / (uint32_t)elapsedMs);
+      if (cadence > boundQ8) cadence = boundQ8;
+    }
+    return cadence > 0 ? cadence : 0;
+  }
+
+  bool isValid() const { return valid; }
+
+private:
+  bool valid;
+  int32_t cadenceQ8;
+  int32_t rateQ8;
+  uint32_t lastUs;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef SLIDING_MIN_MAX_H
+#define SLIDING_MIN_MAX_H
+
+#include <stdint.h>
+
+// Next index of a ring of N entries; a mask when N is a power of two
+template <uint16_t N>
+inline uint16_t ringNext(uint16_t i) {
+  return (N & (N - 1)) == 0 ? (uint16_t)((i + 1) & (N - 1)) : (uint16_t)(i + 1 == N ? 0 : i + 1);
+}
+
+// Minimum and maximum of the last WINDOW samples, updated on every push.
+// Two monotonic deques over fixed rings: each sample is inserted and removed at most once,
+// so a push is O(1) amortized. Memory is 6 * WINDOW bytes, nothing is allocated.
+template <uint16_t WINDOW>
+class SlidingMinMax {
+public:
+  SlidingMinMax() { reset(); }
+
+  void reset() {
+    slot = 0;
+    filled = 0;
+    maxHead = maxCount = 0;
+    minHead = minCount = 0;
+  }
+
+  void push(int16_t v) {
+    // The sample leaving the window used the slot being overwritten; it can only sit at a front
+    if (filled == WINDOW) {
+      if (maxCount && maxQ[maxHead] == slot) { maxHead = next(maxHead); maxCount--; }
+      if (minCount && minQ[minHead] == slot) { minHead = next(minHead); minCount--; }
+    }
+    values[slot] = v;
+
+    // Drop samples that can never be the extreme again
+    while (maxCount && values[maxQ[at(maxHead, maxCount - 1)]] <= v) maxCount--;
+    maxQ[at(maxHead, maxCount++)] = slot;
+    while (minCount && values[minQ[at(minHead, minCount - 1)]] >= v) minCount--;
+    minQ[at(minHead, minCount++)] = slot;
+
+    slot = next(slot);
+    if (filled < WINDOW) filled++;
+  }
+
+  int16_t max() const { return maxCount ? values[maxQ[maxHead]] : 0; }
+  int16_t min() const { return minCount ? values[minQ[minHead]] : 0; }
+  uint16_t size() const { return filled; }
+
+private:
+  int16_t values[WINDOW];   // Last WINDOW samples, written round-robin
+  uint16_t maxQ[WINDOW];    // Slots with decreasing values, front is the maximum
+  uint16_t minQ[WINDOW];    // Slots with increasing values, front is the minimum
+  uint16_t maxHead, maxCount;
+  uint16_t minHead, minCount;
+  uint16_t slot;            // Slot of the next sample
+  uint16_t filled;
+
+  static uint16_t next(uint16_t i) { return ringNext<WINDOW>(i); }
+  static uint16_t at(uint16_t head, uint16_t offset) {
+    uint16_t i = head + offset;
+    return (WINDOW & (WINDOW - 1)) == 0 ? (i & (WINDOW - 1)) : (i >= WINDOW ? i - WINDOW : i);
+  }
+};
+
+#endif
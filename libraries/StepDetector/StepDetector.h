@@ -1,56 +1,200 @@
 #ifndef STEP_DETECTOR_H
 #define STEP_DETECTOR_H
 
+#if defined(ARDUINO)
 #include <Arduino.h>
+#else
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#endif
 #include <LIS2DH12.h>
+#include <LIS2DH12Group.h>
+#include "SlidingMinMax.h"
+#include "StepFilter.h"
+#include "CadenceEstimator.h"
+#include "CadenceTracker.h"
+#include "StepStats.h"
 
-#define FILTER_WINDOW_SIZE 5
-#define PRECISION 1000
-#define SAMPLE_WINDOW 500
-#define MIN_STEP_INTERVAL 200
-#define MAX_STEP_INTERVAL 2500
-#define INTERVAL_WINDOW_SIZE 5
+// Default tuning. Derive from it and override members to make another profile, e.g.
+//   struct MtbConfig : StepDetectorConfig { static constexpr uint16_t minStepInterval = 250; };
+//   BasicStepDetector<MtbConfig> mtbDetector(&accel);
+// getStats() is turned on the same way, in a profile of its own:
+//   struct StatsConfig : StepDetectorConfig { static constexpr bool instrumentation = true; };
+// Window sizes that are powers of two turn the ring index wrap into a mask.
+struct StepDetectorConfig {
+  static constexpr uint8_t filterWindowSize = 1;     // Moving average ahead of the detector (e.g. 5), 1 disables it
+  static constexpr uint8_t dcBlockerShift = 0;       // DC blocker pole 1 - 2^-shift (8: 0.12 Hz at 200 Hz), 0 disables it
+  static constexpr uint8_t lowPassSections = 0;      // Butterworth low-pass of order 2 * sections, 0 disables it
+  static constexpr uint8_t lowPassCutoffHz = 8;      // Above the fastest cadence (5 steps/s at minStepInterval)
+  static constexpr int16_t precision = 1000;
+  static constexpr uint16_t sampleWindow = 500;      // Sliding threshold window, one pedal stroke at the slowest cadence (2.5 s at 200 Hz)
+  static constexpr uint16_t minStepInterval = 200;   // ms
+  static constexpr uint16_t maxStepInterval = 2500;  // ms
+  static constexpr uint8_t intervalWindowSize = 5;
+  static constexpr uint8_t fifoWatermark = 20;       // INT1 fires every 20 samples (100 ms at 200 Hz)
+  static constexpr uint8_t idleFifoWatermark = 1;    // Drain every other sample while idle so wake-up is not delayed
+  static constexpr LIS2DH12::ePowerMode_t activeDataRate = LIS2DH12::eDataRate_200Hz;
+  static constexpr LIS2DH12::ePowerMode_t idleDataRate = LIS2DH12::eDataRate_25Hz;
+  static constexpr int16_t wakeThreshold = 2000;     // Raw sample-to-sample change that ends the low-power idle state
+  static constexpr uint16_t wheelDistanceMm = 2520;  // Distance per crank revolution: 2.1 m wheel circumference * 1.2 gear ratio
+  static constexpr uint8_t maxSpeedKmh = 50;
+  static constexpr int16_t magnitudeNoiseFloor = 400;  // Minimum window swing of the (halved) magnitude before MAGNITUDE reports steps
+  static constexpr bool spectralCadence = false;     // Autocorrelation cadence estimator behind getSpectralBikeSpeed(), compiled out when false
+  static constexpr uint16_t cadenceRateHz = 25;      // It runs on data decimated to this rate
+  static constexpr uint16_t cadenceWindow = 128;     // Decimated samples in its window (5.1 s at 25 Hz)
+  static constexpr uint8_t trackerAlphaQ8 = 128;     // Cadence tracker gains (Q8): 0.5 of each residual goes to the cadence,
+  static constexpr uint8_t trackerBetaQ8 = 32;       // 0.125 of it, per second, to the cadence trend
+  static constexpr uint8_t trackerMaxRateRpmPerS = 60;  // Largest cadence trend the tracker follows
+  static constexpr uint8_t maxObservers = 4;         // Event handlers, registered with addObserver()
+  static constexpr uint16_t speedChangeQ8 = 128;     // Speed change (km/h Q8) that is published as EVENT_CADENCE_CHANGED
+  static constexpr bool instrumentation = false;     // Counters and histograms behind getStats(), compiled out when false
+};
+
+template <class Config>
+class BasicStepDetector {
+  static_assert(Config::minStepInterval < Config::maxStepInterval, "minStepInterval must be below maxStepInterval");
+  static_assert(Config::intervalWindowSize > 0 && Config::filterWindowSize > 0 && Config::sampleWindow > 0, "windows must not be empty");
+  static_assert(Config::fifoWatermark < LIS2DH12_FIFO_SIZE && Config::idleFifoWatermark < LIS2DH12_FIFO_SIZE, "watermark must fit the FIFO");
 
-class StepDetector {
 public:
-  StepDetector(LIS2DH12* accelerometer);
-  void begin();
+  enum ThresholdMode {
+    DYNAMIC_THRESHOLD,   // Raw data, threshold = midpoint of min/max over Config::sampleWindow
+    HIGH_PASS_THRESHOLD  // Sensor high-pass filtered data, fixed threshold at zero
+  };
+
+  enum DetectionEngine {
+    DOMINANT_AXIS,  // Per-axis thresholds, steps on the axis that moved most
+    MAGNITUDE       // Thresholds on |a|, independent of how the sensor is mounted
+  };
+
+  struct StepEvent {
+    uint32_t timestampUs;  // Time of the sample that completed the step
+    int interval;          // ms since the previous step of the same stream
+    uint8_t stream;        // Sensor index within the group
+  };
+
+  enum EventType {
+    EVENT_STEP,              // A step was accepted
+    EVENT_CADENCE_CHANGED,   // The bike speed moved by Config::speedChangeQ8 or more since the last report
+    EVENT_IDLE,              // No sensor saw a step for Config::maxStepInterval, speed dropped to 0
+    EVENT_RESUMED            // First step candidate after idling
+  };
+
+  struct Event {
+    EventType type;
+    uint32_t timestampUs;  // Time of the sample that caused the event
+    uint16_t speedQ8;      // Bike speed with the event applied, km/h * 256
+    int interval;          // EVENT_STEP: ms since the previous step of the same stream
+    uint8_t stream;        // Sensor index within the group
+  };
+
+  // Handlers run synchronously inside detectStep()/processBatch(). A plain function and a
+  // context pointer, so registering one allocates nothing; captureless lambdas convert to it.
+  typedef void (*EventHandler)(const Event& event, void* context);
+
+  BasicStepDetector(LIS2DH12* accelerometer, ThresholdMode mode = DYNAMIC_THRESHOLD, DetectionEngine engine = DOMINANT_AXIS);
+  BasicStepDetector(LIS2DH12Group* sensors, ThresholdMode mode = DYNAMIC_THRESHOLD, DetectionEngine engine = DOMINANT_AXIS); // One detection stream per sensor
+  void begin(int int1Pin = -1); // Pass the INT1 GPIO (of the first sensor) to enable interrupt-driven FIFO acquisition
   bool detectStep(); // Returns true if step detected
+  // Runs a block of samples (one array per axis, timestamps in us) through the detector of the first sensor.
+  // Returns the number of steps found; the first maxEvents of them are written to events.
+  size_t processBatch(const int16_t* x, const int16_t* y, const int16_t* z, const uint32_t* t, size_t n,
+                      StepEvent* events = NULL, size_t maxEvents = 0);
   float getBikeSpeed(); // Returns computed bike speed
+  uint16_t getBikeSpeedQ8(); // Same in km/h * 256, no float conversion
+  float getSpectralBikeSpeed(); // Speed from the autocorrelation cadence of the first sensor, 0 without an estimate or Config::spectralCadence
+  uint16_t getSpectralBikeSpeedQ8();
+  float getCadenceConfidence(); // 0..1, how periodic the signal behind getSpectralBikeSpeed() is
+  // Speed the tracked cadence predicts at timestampUs (sensor group clock), available from the first step interval on
+  float getPredictedBikeSpeed(uint32_t timestampUs);
+  uint16_t getPredictedBikeSpeedQ8(uint32_t timestampUs);
   void updateBikeSpeed();
+  uint32_t getOverrunCount(); // Overrun events flagged by the sensors (STATUS ZYXOR / FIFO OVRN)
+  uint32_t getLostSamples();  // Samples estimated lost from gaps in the reconstructed timestamps
+  bool addObserver(EventHandler handler, void* context = NULL); // false when Config::maxObservers are registered
+  void removeObserver(EventHandler handler, void* context = NULL);
+  // Counters and histograms since construction; all zero unless Config::instrumentation is set
+  const StepDetectorStats& getStats();
 private:
-  LIS2DH12* accel;
-  int16_t sample_old[3] = {0, 0, 0};
-  int16_t sample_new[3] = {0, 0, 0};
-  int16_t xBuffer[FILTER_WINDOW_SIZE] = {0};
-  int16_t yBuffer[FILTER_WINDOW_SIZE] = {0};
-  int16_t zBuffer[FILTER_WINDOW_SIZE] = {0};
-  int bufferIndex = 0;
-  bool bufferFull = false;
-  int16_t ax_max = INT16_MIN, ay_max = INT16_MIN, az_max = INT16_MIN;
-  int16_t ax_min = INT16_MAX, ay_min = INT16_MAX, az_min = INT16_MAX;
-  int16_t ax_max_reg, ay_max_reg, az_max_reg;
-  int16_t ax_min_reg, ay_min_reg, az_min_reg;
-  int sampleCount = 0;
-  float ax_dynamicThreshold = 0, ay_dynamicThreshold = 0, az_dynamicThreshold = 0;
-  int16_t ax_peak2peak, ay_peak2peak, az_peak2peak;
-  bool isIDLE = true;
-  int intervalCounter = 0;
-  int stepInterval = 0;
-  int intervalBuffer[INTERVAL_WINDOW_SIZE] = {0};
+  friend struct StepDetectorProbe;  // Host checks in extras/ reach the fixed-point helpers
+  static constexpr uint8_t speedFracBits = 8;  // Speed and average interval are kept in Q8
+  typedef SlidingMinMax<Config::sampleWindow> Window;
+
+  // Per-sensor detection state; step intervals are measured per stream and share one cadence buffer
+  struct Stream {
+    int16_t sample_old[3] = {0, 0, 0};
+    int16_t sample_new[3] = {0, 0, 0};
+    AxisFilter<Config> xFilter, yFilter, zFilter;
+    Window xWindow, yWindow, zWindow;
+    int32_t ax_threshold2 = 0, ay_threshold2 = 0, az_threshold2 = 0; // Twice the threshold (max + min), compared against 2 * sample
+    int16_t ax_peak2peak, ay_peak2peak, az_peak2peak;
+    bool isIDLE = true;
+    int16_t lastSample[3] = {0, 0, 0};
+    bool hasLastSample = false;
+    bool awaitingStep = false;   // Woken by a jolt, no step candidate yet
+    uint32_t wakeTimeUs = 0;
+    uint32_t lastStepTimeUs = 0;
+    int stepInterval = 0;
+  };
+
+  LIS2DH12Group ownGroup;
+  LIS2DH12Group* sensors;
+  ThresholdMode thresholdMode;
+  DetectionEngine engine;
+  int int1Pin = -1;
+  bool useFifo = false;
+  uint32_t lastDrainUs = 0;
+  Stream streams[LIS2DH12_GROUP_MAX_DEVICES];
+  // Structure-of-arrays scratch for one drained run, filtered in place
+  int16_t blockX[LIS2DH12_FIFO_SIZE];
+  int16_t blockY[LIS2DH12_FIFO_SIZE];
+  int16_t blockZ[LIS2DH12_FIFO_SIZE];
+  uint32_t blockT[LIS2DH12_FIFO_SIZE];
+  bool lowPowerIdle = false;
+  uint32_t samplePeriodUs = 5000;
+  int intervalBuffer[Config::intervalWindowSize] = {0};
   int intervalBufferIndex = 0;
   int numValidIntervals = 0;
-  float bikeSpeed = 0;
-  const int intervalTime = 5;
+  uint16_t bikeSpeedQ8 = 0;
+  CadenceEstimator<Config> cadence;
+  CadenceTracker<Config> tracker;
+  struct Observer {
+    EventHandler handler;
+    void* context;
+  };
+  Observer observers[Config::maxObservers];
+  uint8_t observerCount = 0;
+  bool idle = true;             // Every stream idle, as last published
+  uint16_t reportedSpeedQ8 = 0; // Speed of the last EVENT_CADENCE_CHANGED
+  StepStats<Config::instrumentation> stats;
 
-  void updateLinearShiftRegister(int16_t ax, int16_t ay, int16_t az);
-  void getDynamicThreshold(int16_t ax, int16_t ay, int16_t az);
+  size_t processBlock(uint8_t stream, const int16_t* x, const int16_t* y, const int16_t* z, const uint32_t* t, size_t n,
+                      StepEvent* events, size_t maxEvents);
+  size_t detectOnMagnitude(uint8_t stream, const int16_t* magnitude, const uint32_t* t, size_t n,
+                           StepEvent* events, size_t maxEvents);
+  bool processSample(Stream& s, int16_t ax, int16_t ay, int16_t az, uint32_t timestampUs);
+  bool processMagnitudeSample(Stream& s, int16_t magnitude, uint32_t timestampUs);
+  bool acceptStep(Stream& s, bool isStep, bool wasIdle, uint32_t timestampUs);
+  void publish(EventType type, const Stream& s, uint32_t timestampUs);
+  static int16_t approxMagnitude(int16_t ax, int16_t ay, int16_t az);
+  bool processDrainedBlocks();
+  bool allStreamsIdle();
+  void checkWake(Stream& s, const int16_t* x, const int16_t* y, const int16_t* z, const uint32_t* t, size_t n);
+  void setAcquisitionProfile(bool active);
+  void updateLinearShiftRegister(Stream& s, int16_t ax, int16_t ay, int16_t az);
+  void updateWindow(Window& window, const int16_t* v, int32_t* midSum, size_t n);
   void updateIntervalBuffer(int newInterval);
-  float computeAverageInterval();
-  float mapIntervalToSpeed(float averageInterval);
-  float mapIntervalToSpeedRPM(float averageInterval);
-  int findDominantAxis();
-  bool checkStepCondition(int axis);
+  uint32_t computeAverageIntervalQ8();
+  uint16_t mapIntervalToSpeed(uint32_t averageIntervalQ8);
+  uint16_t mapIntervalToSpeedRPM(uint32_t averageIntervalQ8);
+  int findDominantAxis(Stream& s);
+  bool checkStepCondition(Stream& s, int axis);
 };
 
+#include "StepDetectorImpl.h"
+
+typedef BasicStepDetector<StepDetectorConfig> StepDetector;
+extern template class BasicStepDetector<StepDetectorConfig>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,627 @@
+#ifndef STEP_DETECTOR_IMPL_H
+#define STEP_DETECTOR_IMPL_H
+
+// Member definitions of BasicStepDetector, included from StepDetector.h
+
+template <class Config>
+BasicStepDetector<Config>::BasicStepDetector(LIS2DH12* accelerometer, ThresholdMode mode, DetectionEngine engine)
+  : sensors(&ownGroup), thresholdMode(mode), engine(engine) {
+  ownGroup.addDevice(accelerometer);
+}
+
+template <class Config>
+BasicStepDetector<Config>::BasicStepDetector(LIS2DH12Group* sensors, ThresholdMode mode, DetectionEngine engine)
+  : sensors(sensors), thresholdMode(mode), engine(engine) {}
+
+template <class Config>
+void BasicStepDetector<Config>::begin(int int1Pin) {
+  for (uint8_t i = 0; i < sensors->getDeviceCount(); i++) {
+    LIS2DH12* accel = sensors->getDevice(i);
+    while (!accel->begin()) {
+#if defined(ARDUINO)
+      Serial.println("Initialization failed, please check the connection and I2C address settings");
+      delay(1000);
+#endif
+    }
+
+    if (thresholdMode == HIGH_PASS_THRESHOLD) {
+      // Gravity is removed on the chip with the lowest cut-off, ODR/400: 0.5 Hz at 200 Hz. That is the
+      // bottom of the cadence band, so strokes near 30 rpm lose about 3 dB; a profile running the
+      // active rate at 100 Hz moves the corner to 0.25 Hz.
+      accel->setHighPassFilter(LIS2DH12::eHPF_Normal, LIS2DH12::eHPF_Cutoff_ODR_400, true);
+      accel->resetHighPassFilter();
+    }
+  }
+
+  this->int1Pin = int1Pin;
+  // Several sensors are always drained from their FIFOs as one batch
+  useFifo = int1Pin >= 0 || sensors->getDeviceCount() > 1;
+  // Start idle: low-power rate until the first motion
+  setAcquisitionProfile(false);
+#if defined(ARDUINO)
+  if (int1Pin >= 0) {
+    // The sensor keeps sampling into its FIFO while loop() is blocked; INT1 tells us when to drain it
+    sensors->getDevice(0)->beginInt1(int1Pin, LIS2DH12::eINT1_FifoWatermark);
+  }
+#endif
+}
+
+template <class Config>
+void BasicStepDetector<Config>::setAcquisitionProfile(bool active) {
+  for (uint8_t i = 0; i < sensors->getDeviceCount(); i++) {
+    LIS2DH12* accel = sensors->getDevice(i);
+    // Mode, range and rate go out in one CTRL_REG1..CTRL_REG4 write through the register shadow
+    if (active) {
+      accel->setConfig(LIS2DH12::HIGH_RESOLUTION_MODE, LIS2DH12::eLIS2DH12_2g, Config::activeDataRate);
+    } else {
+      accel->setConfig(LIS2DH12::LOW_POWER_MODE, LIS2DH12::eLIS2DH12_2g, Config::idleDataRate);
+    }
+
+    if (useFifo) {
+      // Restarting the FIFO also drops samples taken at the previous rate
+      accel->setFifoMode(LIS2DH12::eFIFO_Stream, active ? Config::fifoWatermark : Config::idleFifoWatermark);
+    }
+  }
+  lowPowerIdle = !active;
+  uint16_t rate = sensors->getDevice(0)->getAcquireRate();
+  samplePeriodUs = 1000000UL / rate;
+  // Filter state from the previous rate no longer applies
+  for (uint8_t i = 0; i < LIS2DH12_GROUP_MAX_DEVICES; i++) {
+    streams[i].xFilter.configure(rate);
+    streams[i].yFilter.configure(rate);
+    streams[i].zFilter.configure(rate);
+  }
+  cadence.configure(rate);
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::detectStep() {
+  uint32_t start = stats.startCall();
+  if (!useFifo) {
+    if (!sensors->readLatest(0)) return false;
+    bool stepDetected = processDrainedBlocks();
+    stats.endCall(start);
+    return stepDetected;
+  }
+
+  if (int1Pin >= 0) {
+    // Interrupt-driven path: no bus access unless the watermark was reached.
+    // INT1 stays high while the FIFO is above the watermark, which also covers a missed edge.
+    LIS2DH12* accel = sensors->getDevice(0);
+    bool pending = false;
+    uint32_t timestamp;
+    while (accel->popInt1Event(&timestamp)) {
+      // The first watermark edge since the last drain is when sample number FTH+1 arrived
+      if (!pending) sensors->setAnchor(0, timestamp, lowPowerIdle ? Config::idleFifoWatermark : Config::fifoWatermark);
+      pending = true;
+    }
+    if (!pending && !accel->isInt1Asserted()) return false;
+  } else {
+    // No interrupt line: drain on a timer, once per watermark's worth of samples
+    uint32_t now = sensors->now();
+    uint32_t drainInterval = (lowPowerIdle ? Config::idleFifoWatermark : Config::fifoWatermark) * samplePeriodUs;
+    if (now - lastDrainUs < drainInterval) return false;
+    lastDrainUs = now;
+  }
+
+  sensors->drain();
+  bool stepDetected = processDrainedBlocks();
+  stats.endCall(start);
+  return stepDetected;
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::processDrainedBlocks() {
+  // Feed samples of all sensors in timestamp order so steps and intervals come out chronologically.
+  // Each pick takes the longest run of one sensor that precedes every other sensor's next sample.
+  uint8_t next[LIS2DH12_GROUP_MAX_DEVICES] = {0};
+  bool stepDetected = false;
+  while (true) {
+    int pick = -1;
+    uint32_t pickTime = 0;
+    for (uint8_t i = 0; i < sensors->getDeviceCount(); i++) {
+      if (next[i] >= sensors->getSampleCount(i)) continue;
+      uint32_t t = sensors->getSampleTime(i, next[i]);
+      if (pick < 0 || (int32_t)(t - pickTime) < 0) {
+        pick = i;
+        pickTime = t;
+      }
+    }
+    if (pick < 0) break;
+
+    bool bounded = false;
+    uint32_t limit = 0;
+    for (uint8_t i = 0; i < sensors->getDeviceCount(); i++) {
+      if (i == pick || next[i] >= sensors->getSampleCount(i)) continue;
+      uint32_t t = sensors->getSampleTime(i, next[i]);
+      if (!bounded || (int32_t)(t - limit) < 0) {
+        bounded = true;
+        limit = t;
+      }
+    }
+
+    // Deinterleave the run into the SoA scratch
+    const int16_t* xyz = sensors->getSamples(pick);
+    size_t n = 0;
+    while (next[pick] < sensors->getSampleCount(pick) && n < LIS2DH12_FIFO_SIZE) {
+      uint32_t t = sensors->getSampleTime(pick, next[pick]);
+      if (n > 0 && bounded && (int32_t)(t - limit) >= 0) break;
+      blockX[n] = xyz[next[pick] * 3];
+      blockY[n] = xyz[next[pick] * 3 + 1];
+      blockZ[n] = xyz[next[pick] * 3 + 2];
+      blockT[n] = t;
+      n++;
+      next[pick]++;
+    }
+    if (processBlock(pick, blockX, blockY, blockZ, blockT, n, NULL, 0) > 0) stepDetected = true;
+  }
+  return stepDetected;
+}
+
+template <class Config>
+size_t BasicStepDetector<Config>::processBatch(const int16_t* x, const int16_t* y, const int16_t* z, const uint32_t* t, size_t n,
+                                  StepEvent* events, size_t maxEvents) {
+  if (x == NULL || y == NULL || z == NULL || t == NULL) return 0;
+  return processBlock(0, x, y, z, t, n, events, maxEvents);
+}
+
+template <class Config>
+size_t BasicStepDetector<Config>::processBlock(uint8_t stream, const int16_t* x, const int16_t* y, const int16_t* z, const uint32_t* t, size_t n,
+                                  StepEvent* events, size_t maxEvents) {
+  Stream& s = streams[stream];
+  size_t found = 0;
+  stats.addSamples(n);
+  // Window midpoints (max + min) per sample, one FIFO's worth at a time
+  int32_t xMid[LIS2DH12_FIFO_SIZE], yMid[LIS2DH12_FIFO_SIZE], zMid[LIS2DH12_FIFO_SIZE];
+  for (size_t base = 0; base < n; base += LIS2DH12_FIFO_SIZE) {
+    size_t count = n - base < LIS2DH12_FIFO_SIZE ? n - base : LIS2DH12_FIFO_SIZE;
+    // Wake-up looks at the raw data, filtering would blunt the jump it is looking for
+    checkWake(s, x + base, y + base, z + base, t + base, count);
+
+    // Drained runs already sit in the scratch buffers and are filtered in place; caller data is copied first
+    int16_t* fx = blockX;
+    int16_t* fy = blockY;
+    int16_t* fz = blockZ;
+    if (x + base != blockX) {
+      memcpy(fx, x + base, count * sizeof(int16_t));
+      memcpy(fy, y + base, count * sizeof(int16_t));
+      memcpy(fz, z + base, count * sizeof(int16_t));
+    }
+    s.xFilter.process(fx, count);
+    s.yFilter.process(fy, count);
+    s.zFilter.process(fz, count);
+
+    // The cadence estimator follows the first sensor; it wants |a| whatever the detection engine
+    bool spectral = Config::spectralCadence && stream == 0;
+    int16_t magnitude[LIS2DH12_FIFO_SIZE];
+    if (engine == MAGNITUDE || spectral) {
+      for (size_t i = 0; i < count; i++) magnitude[i] = approxMagnitude(fx[i], fy[i], fz[i]);
+    }
+    if (spectral) cadence.process(magnitude, count);
+
+    if (engine == MAGNITUDE) {
+      found += detectOnMagnitude(stream, magnitude, t + base, count, events + (found < maxEvents ? found : 0),
+                                 found < maxEvents ? maxEvents - found : 0);
+      continue;
+    }
+
+    if (thresholdMode == DYNAMIC_THRESHOLD) {
+      // Axes are independent, so each runs through its window as one pass over contiguous data
+      updateWindow(s.xWindow, fx, xMid, count);
+      updateWindow(s.yWindow, fy, yMid, count);
+      updateWindow(s.zWindow, fz, zMid, count);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      if (thresholdMode == DYNAMIC_THRESHOLD) {
+        s.ax_threshold2 = xMid[i];
+        s.ay_threshold2 = yMid[i];
+        s.az_threshold2 = zMid[i];
+      }
+      size_t k = base + i;
+      if (!processSample(s, fx[i], fy[i], fz[i], t[k])) continue;
+      if (found < maxEvents) {
+        events[found].timestampUs = t[k];
+        events[found].interval = s.stepInterval;
+        events[found].stream = stream;
+      }
+      found++;
+    }
+  }
+  if (thresholdMode == DYNAMIC_THRESHOLD && engine == DOMINANT_AXIS) {
+    s.ax_peak2peak = s.xWindow.max() - s.xWindow.min();
+    s.ay_peak2peak = s.yWindow.max() - s.yWindow.min();
+    s.az_peak2peak = s.zWindow.max() - s.zWindow.min();
+  }
+  return found;
+}
+
+template <class Config>
+size_t BasicStepDetector<Config>::detectOnMagnitude(uint8_t stream, const int16_t* magnitude, const uint32_t* t, size_t n,
+                                  StepEvent* events, size_t maxEvents) {
+  Stream& s = streams[stream];
+  int32_t mid[LIS2DH12_FIFO_SIZE];
+  int16_t range[LIS2DH12_FIFO_SIZE];
+
+  // One window instead of three; xWindow is free in this engine. The threshold is always adaptive
+  // because a magnitude is never centred on zero, not even with the high-pass filter
+  for (size_t i = 0; i < n; i++) {
+    s.xWindow.push(magnitude[i]);
+    mid[i] = (int32_t)s.xWindow.max() + s.xWindow.min();
+    range[i] = s.xWindow.max() - s.xWindow.min();
+  }
+
+  size_t found = 0;
+  for (size_t i = 0; i < n; i++) {
+    s.ax_threshold2 = mid[i];
+    s.ax_peak2peak = range[i];
+    if (!processMagnitudeSample(s, magnitude[i], t[i])) continue;
+    if (found < maxEvents) {
+      events[found].timestampUs = t[i];
+      events[found].interval = s.stepInterval;
+      events[found].stream = stream;
+    }
+    found++;
+  }
+  return found;
+}
+
+template <class Config>
+int16_t BasicStepDetector<Config>::approxMagnitude(int16_t ax, int16_t ay, int16_t az) {
+  // (26 max + 11 mid + 8 min) / 64 follows |a| / 2 to within about 6 % up to a constant factor,
+  // which the adaptive threshold absorbs. No square root, and it always fits int16
+  int32_t a = abs(ax), b = abs(ay), c = abs(az);
+  int32_t t;
+  if (a < b) { t = a; a = b; b = t; }
+  if (a < c) { t = a; a = c; c = t; }
+  if (b < c) { t = b; b = c; c = t; }
+  return (int16_t)((a * 26 + b * 11 + c * 8) >> 6);
+}
+
+template <class Config>
+uint32_t BasicStepDetector<Config>::getOverrunCount() {
+  uint32_t count = 0;
+  for (uint8_t i = 0; i < sensors->getDeviceCount(); i++) count += sensors->getDevice(i)->getOverrunCount();
+  return count;
+}
+
+template <class Config>
+uint32_t BasicStepDetector<Config>::getLostSamples() {
+  uint32_t count = 0;
+  for (uint8_t i = 0; i < sensors->getDeviceCount(); i++) count += sensors->getLostSamples(i);
+  return count;
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::allStreamsIdle() {
+  for (uint8_t i = 0; i < sensors->getDeviceCount(); i++) {
+    if (!streams[i].isIDLE) return false;
+  }
+  return true;
+}
+
+template <class Config>
+void BasicStepDetector<Config>::checkWake(Stream& s, const int16_t* x, const int16_t* y, const int16_t* z, const uint32_t* t, size_t n) {
+  if (n == 0) return;
+  // Any real movement while idling in low-power mode brings the full rate back
+  for (size_t i = 0; i < n && lowPowerIdle; i++) {
+    if (s.hasLastSample &&
+        (abs(x[i] - s.lastSample[0]) > Config::wakeThreshold || abs(y[i] - s.lastSample[1]) > Config::wakeThreshold || abs(z[i] - s.lastSample[2]) > Config::wakeThreshold)) {
+      setAcquisitionProfile(true);
+      s.awaitingStep = true;
+      s.wakeTimeUs = t[i];
+    }
+    s.lastSample[0] = x[i];
+    s.lastSample[1] = y[i];
+    s.lastSample[2] = z[i];
+    s.hasLastSample = true;
+  }
+  s.lastSample[0] = x[n - 1];
+  s.lastSample[1] = y[n - 1];
+  s.lastSample[2] = z[n - 1];
+  s.hasLastSample = true;
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::processSample(Stream& s, int16_t ax, int16_t ay, int16_t az, uint32_t timestampUs) {
+  // Thresholds are maintained per block in processBlock(); high-pass data is zero-centred, they stay at 0
+  updateLinearShiftRegister(s, ax, ay, az);
+
+  int dominantAxis = findDominantAxis(s);
+  bool wasIdle = s.isIDLE;
+  bool isStep = checkStepCondition(s, dominantAxis);
+
+/*
+  int differences[3] = {
+    abs(sample_new[0] - sample_old[0]),
+    abs(sample_new[1] - sample_old[1]),
+    abs(sample_new[2] - sample_old[2])
+  };
+  int maxDiff = differences[0], axis = 0;
+  if (differences[1] > maxDiff) { maxDiff = differences[1]; axis = 1; }
+  if (differences[2] > maxDiff) { maxDiff = differences[2]; axis = 2; }
+
+  bool isStep = false;
+  if (axis == 0 && sample_new[0] < sample_old[0] && sample_new[0] < ax_dynamicThreshold) {
+    isStep = true;
+    isIDLE = false;
+  }
+  else if (axis == 1 && sample_new[1] < sample_old[1] && sample_new[1] < ay_dynamicThreshold) {
+    isStep = true;
+    isIDLE = false;
+  }
+  else if (axis == 2 && sample_new[2] < sample_old[2] && sample_new[2] < az_dynamicThreshold) {
+    isStep = true;
+    isIDLE = false;
+  }
+  */
+
+  return acceptStep(s, isStep, wasIdle, timestampUs);
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::processMagnitudeSample(Stream& s, int16_t magnitude, uint32_t timestampUs) {
+  // Same dead-band shift register as the axis path, on one channel
+  s.sample_old[0] = s.sample_new[0];
+  if (abs(magnitude - s.sample_old[0]) > Config::precision) s.sample_new[0] = magnitude;
+
+  // Falling through the window midpoint, and only once the swing clears the noise floor
+  bool wasIdle = s.isIDLE;
+  bool isStep = s.sample_new[0] < s.sample_old[0] && 2 * s.sample_new[0] < s.ax_threshold2 &&
+                s.ax_peak2peak > Config::magnitudeNoiseFloor;
+  if (isStep) s.isIDLE = false;
+
+  return acceptStep(s, isStep, wasIdle, timestampUs);
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::acceptStep(Stream& s, bool isStep, bool wasIdle, uint32_t timestampUs) {
+  // The first candidate after idling starts the interval clock
+  if (wasIdle && !s.isIDLE) {
+    s.lastStepTimeUs = timestampUs;
+    s.awaitingStep = false;
+    if (idle) {
+      idle = false;
+      publish(EVENT_RESUMED, s, timestampUs);
+    }
+  }
+
+  // Intervals come from the reconstructed sample timestamps, not from counting samples,
+  // so batched or late processing and rate changes do not bias the cadence
+  s.stepInterval = s.isIDLE ? 0 : (timestampUs - s.lastStepTimeUs) / 1000;
+
+  // Validate and process the step
+  if (isStep) {
+    if (s.stepInterval < Config::minStepInterval) {
+      isStep = false;
+      stats.rejectStep();
+    } else {
+      isStep = true; 
+      stats.acceptStep(s.stepInterval);
+
+      updateIntervalBuffer(s.stepInterval);
+      updateBikeSpeed();
+      tracker.update(s.stepInterval, timestampUs);
+      s.lastStepTimeUs = timestampUs;
+
+      publish(EVENT_STEP, s, timestampUs);
+      int32_t change = (int32_t)bikeSpeedQ8 - reportedSpeedQ8;
+      if (change >= Config::speedChangeQ8 || change <= -(int32_t)Config::speedChangeQ8) {
+        reportedSpeedQ8 = bikeSpeedQ8;
+        publish(EVENT_CADENCE_CHANGED, s, timestampUs);
+      }
+    }
+  }
+
+  // A bump that woke the sensor but was never followed by a candidate: the interval clock
+  // below never starts, so the full rate is dropped from here instead
+  if (s.awaitingStep && s.isIDLE && (timestampUs - s.wakeTimeUs) / 1000 > Config::maxStepInterval) {
+    s.awaitingStep = false;
+    if (!lowPowerIdle && allStreamsIdle()) setAcquisitionProfile(false);
+  }
+
+  if (s.stepInterval > Config::maxStepInterval) {
+    isStep = false;
+    s.isIDLE = true;
+    // The rider is idle only once no sensor sees steps any more
+    if (allStreamsIdle()) {
+      bikeSpeedQ8 = 0;
+      memset(intervalBuffer, 0, sizeof(intervalBuffer));
+      intervalBufferIndex = 0;
+      numValidIntervals = 0;
+      tracker.reset();
+      setAcquisitionProfile(false);
+      if (!idle) {
+        idle = true;
+        publish(EVENT_IDLE, s, timestampUs);
+        if (reportedSpeedQ8 != 0) {
+          reportedSpeedQ8 = 0;
+          publish(EVENT_CADENCE_CHANGED, s, timestampUs);
+        }
+      }
+    }
+  }
+
+  return isStep;
+}
+
+template <class Config>
+const StepDetectorStats& BasicStepDetector<Config>::getStats() {
+  StepDetectorStats& current = stats.get();
+  if (Config::instrumentation) {
+    // The sensors keep these themselves, only copied on request
+    current.overruns = getOverrunCount();
+    current.lostSamples = getLostSamples();
+  }
+  return current;
+}
+
+template <class Config>
+void BasicStepDetector<Config>::publish(EventType type, const Stream& s, uint32_t timestampUs) {
+  if (observerCount == 0) return;
+  Event event;
+  event.type = type;
+  event.timestampUs = timestampUs;
+  event.speedQ8 = bikeSpeedQ8;
+  event.interval = type == EVENT_STEP ? s.stepInterval : 0;
+  event.stream = (uint8_t)(&s - streams);
+  for (uint8_t i = 0; i < observerCount; i++) {
+    observers[i].handler(event, observers[i].context);
+  }
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::addObserver(EventHandler handler, void* context) {
+  if (handler == NULL || observerCount >= Config::maxObservers) return false;
+  observers[observerCount].handler = handler;
+  observers[observerCount].context = context;
+  observerCount++;
+  return true;
+}
+
+template <class Config>
+void BasicStepDetector<Config>::removeObserver(EventHandler handler, void* context) {
+  for (uint8_t i = 0; i < observerCount; i++) {
+    if (observers[i].handler == handler && observers[i].context == context) {
+      // Keep registration order for the remaining observers
+      for (uint8_t k = i + 1; k < observerCount; k++) observers[k - 1] = observers[k];
+      observerCount--;
+      return;
+    }
+  }
+}
+
+template <class Config>
+void BasicStepDetector<Config>::updateBikeSpeed() {
+  // Only update speed if we have enough valid intervals
+  if (numValidIntervals > 3) {
+    uint32_t avgIntervalQ8 = computeAverageIntervalQ8();
+    bikeSpeedQ8 = mapIntervalToSpeedRPM(avgIntervalQ8);
+    // Serial.print("Bike speed updated: "); Serial.print(getBikeSpeed()); Serial.println(" km/h");
+  } else {
+    // Not enough data yet; keep speed at 0 or last value
+    bikeSpeedQ8 = 0; // Or leave as-is, depending on preference
+    // Serial.println("Not enough intervals to update bike speed");
+  }
+}
+
+
+template <class Config>
+int BasicStepDetector<Config>::findDominantAxis(Stream& s) {
+  int differences[3] = {
+    abs(s.sample_new[0] - s.sample_old[0]),
+    abs(s.sample_new[1] - s.sample_old[1]),
+    abs(s.sample_new[2] - s.sample_old[2])
+  };
+  int maxDiff = differences[0], axis = 0;
+  if (differences[1] > maxDiff) { maxDiff = differences[1]; axis = 1; }
+  if (differences[2] > maxDiff) { axis = 2; }
+  return axis;
+}
+
+template <class Config>
+bool BasicStepDetector<Config>::checkStepCondition(Stream& s, int axis) {
+  bool isStep = false;
+  switch (axis) {
+    case 0: if (s.sample_new[0] < s.sample_old[0] && 2 * s.sample_new[0] < s.ax_threshold2) isStep = true; break;
+    case 1: if (s.sample_new[1] < s.sample_old[1] && 2 * s.sample_new[1] < s.ay_threshold2) isStep = true; break;
+    case 2: if (s.sample_new[2] < s.sample_old[2] && 2 * s.sample_new[2] < s.az_threshold2) isStep = true; break;
+  }
+  if (isStep) s.isIDLE = false;
+  return isStep;
+}
+
+template <class Config>
+float BasicStepDetector<Config>::getBikeSpeed() {
+  return bikeSpeedQ8 / (float)(1 << speedFracBits);
+}
+
+template <class Config>
+uint16_t BasicStepDetector<Config>::getBikeSpeedQ8() {
+  return bikeSpeedQ8;
+}
+
+template <class Config>
+float BasicStepDetector<Config>::getSpectralBikeSpeed() {
+  return getSpectralBikeSpeedQ8() / (float)(1 << speedFracBits);
+}
+
+template <class Config>
+uint16_t BasicStepDetector<Config>::getSpectralBikeSpeedQ8() {
+  return mapIntervalToSpeedRPM(cadence.getIntervalQ8());
+}
+
+template <class Config>
+float BasicStepDetector<Config>::getCadenceConfidence() {
+  return cadence.getConfidenceQ8() / 256.0f;
+}
+
+template <class Config>
+float BasicStepDetector<Config>::getPredictedBikeSpeed(uint32_t timestampUs) {
+  return getPredictedBikeSpeedQ8(timestampUs) / (float)(1 << speedFracBits);
+}
+
+template <class Config>
+uint16_t BasicStepDetector<Config>::getPredictedBikeSpeedQ8(uint32_t timestampUs) {
+  int32_t cadenceQ8 = tracker.predictQ8(timestampUs);
+  if (cadenceQ8 <= 0) return 0;
+  // rpm to the average interval in ms, both Q8
+  return mapIntervalToSpeedRPM((uint32_t)((60000ULL << 16) / (uint32_t)cadenceQ8));
+}
+
+template <class Config>
+void BasicStepDetector<Config>::updateLinearShiftRegister(Stream& s, int16_t ax, int16_t ay, int16_t az) {
+  memcpy(s.sample_old, s.sample_new, sizeof(s.sample_new));
+  if (abs(ax - s.sample_old[0]) > Config::precision) s.sample_new[0] = ax;
+  if (abs(ay - s.sample_old[1]) > Config::precision) s.sample_new[1] = ay;
+  if (abs(az - s.sample_old[2]) > Config::precision) s.sample_new[2] = az;
+}
+
+template <class Config>
+void BasicStepDetector<Config>::updateWindow(Window& window, const int16_t* v, int32_t* midSum, size_t n) {
+  // Threshold follows the midpoint of the last sampleWindow samples, updated every sample
+  for (size_t i = 0; i < n; i++) {
+    window.push(v[i]);
+    midSum[i] = (int32_t)window.max() + window.min();
+  }
+}
+
+
+template <class Config>
+void BasicStepDetector<Config>::updateIntervalBuffer(int newInterval) {
+  intervalBuffer[intervalBufferIndex] = newInterval;
+  intervalBufferIndex = ringNext<Config::intervalWindowSize>(intervalBufferIndex);
+  if (numValidIntervals < Config::intervalWindowSize) numValidIntervals++;
+}
+
+template <class Config>
+uint32_t BasicStepDetector<Config>::computeAverageIntervalQ8() {
+  uint32_t sum = 0;
+  for (int i = 0; i < numValidIntervals; i++) sum += intervalBuffer[i];
+  return numValidIntervals > 0 ? (sum << speedFracBits) / numValidIntervals : 0;
+}
+
+template <class Config>
+uint16_t BasicStepDetector<Config>::mapIntervalToSpeed(uint32_t averageIntervalQ8) {
+  const uint32_t minQ8 = (uint32_t)Config::minStepInterval << speedFracBits;
+  const uint32_t maxQ8 = (uint32_t)Config::maxStepInterval << speedFracBits;
+  if (averageIntervalQ8 <= minQ8) return Config::maxSpeedKmh << speedFracBits;
+  if (averageIntervalQ8 >= maxQ8) return 0;
+  // Linear from maxSpeedKmh at the shortest interval to 0 at the longest
+  return (uint32_t)Config::maxSpeedKmh * (maxQ8 - averageIntervalQ8) / (Config::maxStepInterval - Config::minStepInterval);
+}
+
+
+template <class Config>
+uint16_t BasicStepDetector<Config>::mapIntervalToSpeedRPM(uint32_t averageIntervalQ8) {
+  // km/h = 60000 / interval [rpm] * distance [mm] * 60 / 10^6, folded into one constant:
+  // speedQ8 = K / intervalQ8 with K in Q16 (9072 << 16 for the default 2.52 m per revolution)
+  static const uint32_t speedConstQ16 =
+    (uint32_t)((60000ULL * Config::wheelDistanceMm * 60 << (2 * speedFracBits)) / 1000000ULL);
+  if (averageIntervalQ8 == 0) return 0;
+
+  uint32_t speedQ8 = (speedConstQ16 + averageIntervalQ8 / 2) / averageIntervalQ8;
+  return speedQ8 > ((uint32_t)Config::maxSpeedKmh << speedFracBits) ? Config::maxSpeedKmh << speedFracBits : speedQ8;
+}
+
+#endif
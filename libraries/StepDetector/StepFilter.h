@@ -0,0 +1,178 @@
+#ifndef STEP_FILTER_H
+#define STEP_FILTER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "SlidingMinMax.h"
+
+// Integer filter stages for one accelerometer axis. process() filters a block in place, so a
+// drained FIFO run goes through every stage without a copy. Only LowPassDesign uses float,
+// and only when the sample rate changes.
+
+inline int16_t saturate16(int32_t v) {
+  return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+// Boxcar average of the last N samples. A running sum keeps the cost independent of N.
+template <uint8_t N>
+class MovingAverage {
+public:
+  MovingAverage() { reset(); }
+
+  void reset() {
+    index = 0;
+    filled = 0;
+    sum = 0;
+  }
+
+  void process(int16_t* v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      if (filled == N) sum -= buffer[index];
+      else filled++;
+      buffer[index] = v[i];
+      sum += v[i];
+      index = ringNext<N>(index);
+      // Division by the constant N compiles to a multiply once the window is full
+      v[i] = (int16_t)(filled == N ? sum / N : sum / filled);
+    }
+  }
+
+private:
+  int16_t buffer[N];
+  uint8_t index;
+  uint8_t filled;
+  int32_t sum;
+};
+
+// y[n] = x[n] - x[n-1] + (1 - 2^-SHIFT) * y[n-1]; removes gravity and sensor offset.
+// The -3 dB corner is about fs / (2 * pi * 2^SHIFT), 0.12 Hz at 200 Hz with SHIFT = 8.
+template <uint8_t SHIFT>
+class DcBlocker {
+public:
+  DcBlocker() { reset(); }
+
+  void reset() {
+    primed = false;
+    x1 = 0;
+    y1Q8 = 0;
+  }
+
+  void process(int16_t* v, size_t n) {
+    if (!primed && n > 0) {
+      // Start from the first sample so the existing offset does not show up as a step
+      x1 = v[0];
+      primed = true;
+    }
+    for (size_t i = 0; i < n; i++) {
+      int32_t yQ8 = ((int32_t)(v[i] - x1) << 8) + y1Q8 - (y1Q8 >> SHIFT);
+      x1 = v[i];
+      y1Q8 = yQ8;
+      v[i] = saturate16((yQ8 + 128) >> 8);
+    }
+  }
+
+private:
+  bool primed;
+  int16_t x1;
+  int32_t y1Q8;
+};
+
+// Biquad coefficients in Q14, a0 normalised to 1
+struct BiquadCoeffs {
+  int32_t b0, b1, b2, a1, a2;
+};
+
+// Second-order section, direct form I with error feedback so the low cut-off does not
+// turn the output rounding into a slow offset.
+class Biquad {
+public:
+  Biquad() {
+    BiquadCoeffs passThrough = {1 << 14, 0, 0, 0, 0};
+    setCoeffs(passThrough);
+  }
+
+  void setCoeffs(const BiquadCoeffs& coeffs) {
+    c = coeffs;
+    reset();
+  }
+
+  void reset() {
+    x1 = x2 = y1 = y2 = 0;
+    err = 0;
+  }
+
+  void process(int16_t* v, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      int32_t acc = c.b0 * v[i] + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2 + err;
+      int16_t y = saturate16(acc >> 14);
+      err = acc & 0x3FFF;
+      x2 = x1;
+      x1 = v[i];
+      y2 = y1;
+      y1 = y;
+      v[i] = y;
+    }
+  }
+
+private:
+  BiquadCoeffs c;
+  int16_t x1, x2, y1, y2;
+  int32_t err;
+};
+
+struct LowPassDesign {
+  // Section k of a Butterworth low-pass built from `sections` biquads (order 2 * sections), RBJ form
+  static BiquadCoeffs butterworth(float sampleRateHz, float cutoffHz, uint8_t sections, uint8_t k) {
+    float q = 1.0f / (2.0f * cosf((2 * k + 1) * (float)M_PI / (4.0f * sections)));
+    float w0 = 2.0f * (float)M_PI * cutoffHz / sampleRateHz;
+    float alpha = sinf(w0) / (2.0f * q);
+    float cosw = cosf(w0);
+    float a0 = 1.0f + alpha;
+    BiquadCoeffs c;
+    c.b0 = toQ14((1.0f - cosw) / 2.0f / a0);
+    c.b1 = toQ14((1.0f - cosw) / a0);
+    c.b2 = c.b0;
+    c.a1 = toQ14(-2.0f * cosw / a0);
+    c.a2 = toQ14((1.0f - alpha) / a0);
+    return c;
+  }
+
+  static int32_t toQ14(float v) { return (int32_t)lrintf(v * (1 << 14)); }
+};
+
+// Moving average -> DC blocker -> cascaded low-pass, each stage compiled out when disabled:
+// filterWindowSize <= 1, dcBlockerShift == 0, lowPassSections == 0.
+template <class Config>
+class AxisFilter {
+public:
+  // Recomputes the low-pass for the current sample rate and clears all state
+  void configure(uint16_t sampleRateHz) {
+    // Keep the corner below Nyquist when the rate drops for idling
+    float cutoffHz = Config::lowPassCutoffHz;
+    if (cutoffHz > sampleRateHz * 0.4f) cutoffHz = sampleRateHz * 0.4f;
+    for (uint8_t k = 0; k < Config::lowPassSections; k++) {
+      lowPass[k].setCoeffs(LowPassDesign::butterworth(sampleRateHz, cutoffHz, Config::lowPassSections, k));
+    }
+    reset();
+  }
+
+  void reset() {
+    average.reset();
+    dcBlocker.reset();
+    for (uint8_t k = 0; k < Config::lowPassSections; k++) lowPass[k].reset();
+  }
+
+  void process(int16_t* v, size_t n) {
+    if (Config::filterWindowSize > 1) average.process(v, n);
+    if (Config::dcBlockerShift > 0) dcBlocker.process(v, n);
+    for (uint8_t k = 0; k < Config::lowPassSections; k++) lowPass[k].process(v, n);
+  }
+
+private:
+  MovingAverage<(Config::filterWindowSize > 1 ? Config::filterWindowSize : 1)> average;
+  DcBlocker<Config::dcBlockerShift> dcBlocker;
+  Biquad lowPass[Config::lowPassSections > 0 ? Config::lowPassSections : 1];
+};
+
+#endif
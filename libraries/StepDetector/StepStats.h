@@ -0,0 +1,103 @@
+#ifndef STEP_STATS_H
+#define STEP_STATS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Esp.h>
+#define STEP_DETECTOR_CYCLES() ((uint32_t)ESP.getCycleCount())
+#elif defined(ARDUINO)
+#define STEP_DETECTOR_CYCLES() ((uint32_t)micros())   // No cycle counter, microseconds instead
+#elif defined(__linux__)
+#include <time.h>
+static inline uint32_t stepDetectorHostNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)(now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+#define STEP_DETECTOR_CYCLES() stepDetectorHostNs()   // Nanoseconds on the host
+#else
+#define STEP_DETECTOR_CYCLES() ((uint32_t)0)
+#endif
+
+// Counts per power-of-two range: bucket 0 holds 0 and 1, bucket k holds [2^k, 2^(k+1)),
+// the last bucket everything above
+template <uint8_t N>
+struct Log2Histogram {
+  uint32_t buckets[N];
+
+  void add(uint32_t v) {
+    uint8_t k = 0;
+    while (v > 1 && k < N - 1) {
+      v >>= 1;
+      k++;
+    }
+    buckets[k]++;
+  }
+};
+
+// Counts per WIDTH-wide range starting at 0, the last bucket everything above
+template <uint8_t N, uint16_t WIDTH>
+struct LinearHistogram {
+  uint32_t buckets[N];
+
+  void add(uint32_t v) {
+    uint32_t k = v / WIDTH;
+    buckets[k < N ? k : N - 1]++;
+  }
+};
+
+// What the detector did since it was constructed, see BasicStepDetector::getStats()
+struct StepDetectorStats {
+  uint32_t calls;            // detectStep() calls
+  uint32_t samples;          // Samples run through the detector, all sensors
+  uint32_t lostSamples;      // Estimated from timestamp gaps
+  uint32_t overruns;         // Overruns flagged by the sensors (STATUS ZYXOR / FIFO OVRN)
+  uint32_t stepsAccepted;
+  uint32_t stepsRejected;    // Closer than minStepInterval to the previous step
+  Log2Histogram<24> callCycles;        // Cycles per detectStep() call that processed samples
+  LinearHistogram<26, 100> intervalsMs;  // Accepted step intervals, 100 ms buckets up to 2.5 s
+};
+
+// Collection behind a compile-time switch: the disabled variant has no state and every call
+// is an empty inline, so it costs nothing, not even the cycle counter read.
+template <bool ENABLED>
+class StepStats {
+public:
+  StepStats() { memset(&data, 0, sizeof(data)); }
+
+  uint32_t startCall() {
+    data.calls++;
+    return STEP_DETECTOR_CYCLES();
+  }
+  void endCall(uint32_t start) { data.callCycles.add(STEP_DETECTOR_CYCLES() - start); }
+  void addSamples(uint32_t n) { data.samples += n; }
+  void acceptStep(uint32_t intervalMs) {
+    data.stepsAccepted++;
+    data.intervalsMs.add(intervalMs);
+  }
+  void rejectStep() { data.stepsRejected++; }
+
+  StepDetectorStats& get() { return data; }
+
+private:
+  StepDetectorStats data;
+};
+
+template <>
+class StepStats<false> {
+public:
+  uint32_t startCall() { return 0; }
+  void endCall(uint32_t) {}
+  void addSamples(uint32_t) {}
+  void acceptStep(uint32_t) {}
+  void rejectStep() {}
+
+  StepDetectorStats& get() {
+    static StepDetectorStats none;
+    return none;
+  }
+};
+
+#endif
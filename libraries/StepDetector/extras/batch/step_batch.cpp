@@ -0,0 +1,286 @@
+// Reprocesses recorded rides on a server with the firmware's StepDetector, one session per trace,
+// spread over all cores. Each session replays its trace through the same emulated sensor as
+// step_replay (../replay/TraceSensor.h), so the detector runs exactly as on the bike.
+//
+// Build on Linux, from this directory:
+//   g++ -std=gnu++17 -O2 -pthread -I../../../LIS2DH12 -I../.. step_batch.cpp
+//     ../../../LIS2DH12/*.cpp ../../StepDetector.cpp -o step_batch
+//
+// Usage: step_batch [--threads N] [--interval MS] [--out DIR] trace...
+//   Traces are CSV or binary captures (see ../replay/Trace.h), memory-mapped, never copied.
+//   For every trace DIR/<name>.series.csv receives one row per interval of ride time (1000 ms):
+//     t_ms,steps,speed_kmh,cadence_rpm,predicted_kmh,spectral_kmh,confidence
+//   and stdout one summary line per session. Traces must have distinct names once the directory
+//   and extension are dropped. Sessions are dealt to per-thread queues, largest first; a thread
+//   that runs out steals the smallest session left in another queue.
+//
+// Exit status: 0 if every session was processed, 1 if some failed, 2 on bad arguments.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <StepDetector.h>
+#include "../replay/Trace.h"
+#include "../replay/TraceSensor.h"
+
+// The firmware profile plus the spectral cadence for the spectral_kmh and confidence columns
+struct BatchConfig : StepDetectorConfig {
+  static constexpr bool spectralCadence = true;
+};
+typedef BasicStepDetector<BatchConfig> BatchDetector;
+
+struct Session {
+  std::string path;
+  std::string name;   // Output name: file name without directory and extension
+  size_t bytes;
+  // Filled in by the worker
+  bool ok;
+  std::string error;
+  size_t samples;
+  size_t steps;
+  double seconds;     // Ride time
+};
+
+// Trace file mapped read-only for the lifetime of the object
+class MappedFile {
+public:
+  ~MappedFile() {
+    if (data != MAP_FAILED && size) munmap(data, size);
+  }
+
+  bool open(const char* path, std::string& error) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      error = std::string("cannot open ") + path;
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      error = std::string("cannot stat ") + path;
+      return false;
+    }
+    size = (size_t)st.st_size;
+    if (size) {
+      data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data != MAP_FAILED) madvise(data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    if (size && data == MAP_FAILED) {
+      error = std::string("cannot map ") + path;
+      return false;
+    }
+    return true;
+  }
+
+  const char* bytes() const { return size ? (const char*)data : ""; }
+  size_t length() const { return size; }
+
+private:
+  void* data = MAP_FAILED;
+  size_t size = 0;
+};
+
+static double speedToRpm(double kmh) {
+  // Inverse of mapIntervalToSpeed(): km/h = rpm * wheel (mm) * 60 / 1e6
+  return kmh * 1e6 / (60.0 * StepDetectorConfig::wheelDistanceMm);
+}
+
+static void processSession(Session& session, const std::string& outDir, uint32_t intervalUs) {
+  MappedFile file;
+  TraceReader reader;
+  if (!file.open(session.path.c_str(), session.error) || !reader.open(file.bytes(), file.length(), session.error)) {
+    return;
+  }
+
+  std::string outPath = outDir + "/" + session.name + ".series.csv";
+  FILE* out = fopen(outPath.c_str(), "w");
+  if (out == NULL) {
+    session.error = "cannot write " + outPath;
+    return;
+  }
+  static const size_t outBufferSize = 1 << 16;
+  std::unique_ptr<char[]> outBuffer(new char[outBufferSize]);
+  setvbuf(out, outBuffer.get(), _IOFBF, outBufferSize);
+  fprintf(out, "t_ms,steps,speed_kmh,cadence_rpm,predicted_kmh,spectral_kmh,confidence\n");
+
+  TraceSensor sensor;
+  std::unique_ptr<BatchDetector> detector(new BatchDetector(sensor.getGroup()));
+  detector->begin();
+
+  bool started = false;
+  uint32_t startUs = 0, nextRowUs = 0, lastUs = 0;
+  size_t steps = 0;
+  auto writeRow = [&](uint32_t timeUs) {
+    float speed = detector->getBikeSpeed();
+    fprintf(out, "%lu,%zu,%.2f,%.1f,%.2f,%.2f,%.2f\n", (unsigned long)((timeUs - startUs) / 1000), steps, speed,
+            speedToRpm(speed), detector->getPredictedBikeSpeed(timeUs), detector->getSpectralBikeSpeed(),
+            detector->getCadenceConfidence());
+  };
+  auto onTick = [&](uint32_t tick) {
+    // Rows report the state before the first conversion at or past their time
+    while ((int32_t)(tick - nextRowUs) >= 0) {
+      writeRow(nextRowUs);
+      nextRowUs += intervalUs;
+    }
+    if (detector->detectStep()) steps++;
+    lastUs = tick;
+  };
+
+  TraceSample chunk[256];
+  size_t n;
+  while ((n = reader.read(chunk, 256, session.error)) > 0) {
+    if (!started) {
+      startUs = nextRowUs = lastUs = chunk[0].timestampUs;
+      started = true;
+    }
+    for (size_t i = 0; i < n; i++) sensor.feed(chunk[i], onTick);
+  }
+  sensor.finish(onTick);
+  if (started) writeRow(lastUs);
+
+  if (fclose(out) != 0 && session.error.empty()) session.error = "cannot write " + outPath;
+  session.samples = sensor.getSamples();
+  session.steps = steps;
+  session.seconds = (lastUs - startUs) / 1e6;
+  session.ok = session.error.empty();
+}
+
+// Per-thread session queue, smallest session at the front. The owner takes from the back, so it
+// works largest first; thieves take from the front, so they rarely meet the owner and only
+// pick up the small sessions left at the end.
+class WorkQueue {
+public:
+  void push(size_t job) {
+    std::lock_guard<std::mutex> guard(lock);
+    jobs.push_back(job);
+  }
+
+  bool pop(size_t& job) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (jobs.empty()) return false;
+    job = jobs.back();
+    jobs.pop_back();
+    return true;
+  }
+
+  bool steal(size_t& job) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (jobs.empty()) return false;
+    job = jobs.front();
+    jobs.pop_front();
+    return true;
+  }
+
+private:
+  std::mutex lock;
+  std::deque<size_t> jobs;
+};
+
+static void usage(void) {
+  fprintf(stderr, "usage: step_batch [--threads N] [--interval MS] [--out DIR] trace...\n");
+}
+
+int main(int argc, char** argv) {
+  unsigned threadCount = std::thread::hardware_concurrency();
+  uint32_t intervalUs = 1000000;
+  std::string outDir = ".";
+  std::vector<Session> sessions;
+  std::set<std::string> names;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threadCount = (unsigned)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+      intervalUs = (uint32_t)(atof(argv[++i]) * 1000);
+    } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+      outDir = argv[++i];
+    } else if (argv[i][0] == '-') {
+      usage();
+      return 2;
+    } else {
+      Session session = {};
+      session.path = argv[i];
+      const char* base = strrchr(argv[i], '/');
+      session.name = base ? base + 1 : argv[i];
+      size_t dot = session.name.rfind('.');
+      if (dot != std::string::npos && dot > 0) session.name.erase(dot);
+      // ride.csv and ride.bin would both write ride.series.csv, one result lost
+      if (!names.insert(session.name).second) {
+        fprintf(stderr, "%s: another trace is also named %s\n", argv[i], session.name.c_str());
+        return 2;
+      }
+      struct stat st;
+      session.bytes = stat(argv[i], &st) == 0 ? (size_t)st.st_size : 0;
+      sessions.push_back(session);
+    }
+  }
+  if (sessions.empty() || intervalUs == 0) {
+    usage();
+    return 2;
+  }
+  if (threadCount == 0) threadCount = 1;
+  if (threadCount > sessions.size()) threadCount = (unsigned)sessions.size();
+
+  // Largest sessions first, dealt round-robin, so the long tail is made of small ones
+  std::vector<size_t> order(sessions.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return sessions[a].bytes > sessions[b].bytes; });
+  std::vector<WorkQueue> queues(threadCount);
+  // Owners pop from the back: push each queue's share smallest first
+  for (size_t k = order.size(); k-- > 0;) queues[k % threadCount].push(order[k]);
+
+  std::atomic<size_t> stolen(0);
+  auto worker = [&](unsigned self) {
+    size_t job;
+    while (true) {
+      bool found = queues[self].pop(job);
+      for (unsigned k = 1; !found && k < threadCount; k++) {
+        found = queues[(self + k) % threadCount].steal(job);
+        if (found) stolen++;
+      }
+      // No session is ever added once workers run, so empty queues everywhere means done
+      if (!found) return;
+      processSession(sessions[job], outDir, intervalUs);
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned t = 1; t < threadCount; t++) threads.emplace_back(worker, t);
+  worker(0);
+  for (std::thread& t : threads) t.join();
+  double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  size_t failed = 0, samples = 0;
+  double rideSeconds = 0;
+  for (const Session& s : sessions) {
+    if (!s.ok) {
+      fprintf(stderr, "%s: %s\n", s.path.c_str(), s.error.c_str());
+      failed++;
+      continue;
+    }
+    printf("%s samples=%zu steps=%zu ride=%.1fs\n", s.name.c_str(), s.samples, s.steps, s.seconds);
+    samples += s.samples;
+    rideSeconds += s.seconds;
+  }
+  fprintf(stderr, "%zu sessions, %u threads, %zu stolen, %.2f s wall, %.0f samples/s, %.0fx real time\n",
+          sessions.size() - failed, threadCount, stolen.load(), wall, wall > 0 ? samples / wall : 0,
+          wall > 0 ? rideSeconds / wall : 0);
+  return failed ? 1 : 0;
+}
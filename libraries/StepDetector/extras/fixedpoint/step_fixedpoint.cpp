@@ -0,0 +1,168 @@
+// Checks the fixed-point speed pipeline and step threshold of StepDetector against the float
+// code they replaced, and times both.
+//
+// Build and run on Linux, from this directory:
+//   g++ -std=gnu++17 -O2 -I../../../LIS2DH12 -I../.. step_fixedpoint.cpp
+//     ../../../LIS2DH12/*.cpp ../../StepDetector.cpp -o step_fixedpoint
+//   ./step_fixedpoint
+//
+// - Speed: every interval sum from minStepInterval to maxStepInterval per interval, for 1 up to
+//   intervalWindowSize intervals, through computeAverageIntervalQ8() and mapIntervalToSpeedRPM().
+//   The float reference is the old computeAverageInterval() / mapIntervalToSpeedRPM(); the
+//   fixed-point speed must stay within one Q8 step (1/256 km/h) of it.
+// - Threshold: checkStepCondition() (2 * sample against max + min) must agree exactly with the
+//   old float midpoint test, for every sample value over random and extreme windows.
+// - Timing: both versions of each, in STEP_DETECTOR_CYCLES() units per call (ns on the host).
+//   The host has an FPU, so this only shows the integer path is not slower; the gap to soft
+//   float shows on the ESP32-C3.
+//
+// Exit status: 0 when both checks pass, 1 otherwise.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <random>
+#include <StepDetector.h>
+#include <LIS2DH12Transport.h>
+
+typedef StepDetectorConfig Config;
+static const int speedOne = 256;   // One km/h in Q8
+
+// Declared a friend of BasicStepDetector
+struct StepDetectorProbe {
+  static uint16_t speedQ8(StepDetector& d, const int* intervals, int n) {
+    for (int i = 0; i < n; i++) d.intervalBuffer[i] = intervals[i];
+    d.numValidIntervals = n;
+    return d.mapIntervalToSpeedRPM(d.computeAverageIntervalQ8());
+  }
+
+  static bool stepCondition(StepDetector& d, int16_t sampleOld, int16_t sampleNew, int32_t threshold2) {
+    auto& s = d.streams[0];
+    s.sample_old[0] = sampleOld;
+    s.sample_new[0] = sampleNew;
+    s.ax_threshold2 = threshold2;
+    return d.checkStepCondition(s, 0);
+  }
+};
+
+// The float code before the fixed-point change
+static float floatSpeed(const int* intervals, int n) {
+  int sum = 0;
+  for (int i = 0; i < n; i++) sum += intervals[i];
+  float averageInterval = n > 0 ? (float)sum / n : 0.0f;
+  float cadence = 60000.0f / averageInterval;
+  const float distancePerRevolution = 2.1 * 1.2f;
+  float speed = cadence * distancePerRevolution * 0.06f;
+  return speed < 0.0f ? 0.0f : (speed > 50.0f ? 50.0f : speed);
+}
+
+static bool floatStepCondition(int16_t sampleOld, int16_t sampleNew, int16_t windowMax, int16_t windowMin) {
+  float threshold = (windowMax + windowMin) / 2.0;
+  return sampleNew < sampleOld && sampleNew < threshold;
+}
+
+// Spreads sum over n intervals as evenly as possible
+static void fillIntervals(int* intervals, int n, int sum) {
+  for (int i = 0; i < n; i++) intervals[i] = sum / n + (i < sum % n ? 1 : 0);
+}
+
+static bool checkSpeed(StepDetector& d) {
+  bool ok = true;
+  int intervals[Config::intervalWindowSize];
+  for (int n = 1; n <= Config::intervalWindowSize; n++) {
+    double worst = 0;
+    int worstSum = 0;
+    long cases = 0;
+    for (int sum = n * Config::minStepInterval; sum <= n * Config::maxStepInterval; sum++) {
+      fillIntervals(intervals, n, sum);
+      double error = fabs(StepDetectorProbe::speedQ8(d, intervals, n) / (double)speedOne - floatSpeed(intervals, n));
+      if (error > worst) {
+        worst = error;
+        worstSum = sum;
+      }
+      cases++;
+    }
+    bool pass = worst <= 1.0 / speedOne;
+    printf("speed, %d interval%s: %6ld sums, max error %.5f km/h (%.2f LSB) at sum %d ms  %s\n",
+           n, n > 1 ? "s" : " ", cases, worst, worst * speedOne, worstSum, pass ? "ok" : "FAIL");
+    ok = ok && pass;
+  }
+  return ok;
+}
+
+static bool checkThreshold(StepDetector& d) {
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<int> value(INT16_MIN, INT16_MAX);
+  const int extremes[][2] = {{INT16_MAX, INT16_MAX}, {INT16_MIN, INT16_MIN}, {INT16_MAX, INT16_MIN},
+                             {1, 0}, {0, -1}, {1, -2}, {-1, -2}, {0, 0}};
+  const int windows = 2000;
+  long mismatches = 0, cases = 0;
+  for (int w = 0; w < windows; w++) {
+    int a, b;
+    if (w < (int)(sizeof(extremes) / sizeof(extremes[0]))) {
+      a = extremes[w][0];
+      b = extremes[w][1];
+    } else {
+      a = value(rng);
+      b = value(rng);
+    }
+    int16_t windowMax = (int16_t)(a > b ? a : b), windowMin = (int16_t)(a > b ? b : a);
+    int32_t threshold2 = (int32_t)windowMax + windowMin;
+    for (int v = INT16_MIN; v < INT16_MAX; v++) {
+      // Falling sample, so only the threshold decides
+      int16_t sampleNew = (int16_t)v, sampleOld = (int16_t)(v + 1);
+      if (StepDetectorProbe::stepCondition(d, sampleOld, sampleNew, threshold2) !=
+          floatStepCondition(sampleOld, sampleNew, windowMax, windowMin)) {
+        mismatches++;
+      }
+      cases++;
+    }
+  }
+  printf("threshold: %ld comparisons over %d windows, %ld mismatches  %s\n", cases, windows, mismatches,
+         mismatches == 0 ? "ok" : "FAIL");
+  return mismatches == 0;
+}
+
+static volatile uint32_t sink;
+
+static void timeSpeed(StepDetector& d) {
+  const int rounds = 200000;
+  int intervals[Config::intervalWindowSize];
+  const int n = Config::intervalWindowSize;
+  uint32_t start = STEP_DETECTOR_CYCLES();
+  for (int i = 0; i < rounds; i++) {
+    fillIntervals(intervals, n, n * (Config::minStepInterval + i % 2300));
+    sink += StepDetectorProbe::speedQ8(d, intervals, n);
+  }
+  uint32_t fixedTime = STEP_DETECTOR_CYCLES() - start;
+  start = STEP_DETECTOR_CYCLES();
+  for (int i = 0; i < rounds; i++) {
+    fillIntervals(intervals, n, n * (Config::minStepInterval + i % 2300));
+    sink += (uint32_t)floatSpeed(intervals, n);
+  }
+  uint32_t floatTime = STEP_DETECTOR_CYCLES() - start;
+  printf("timing, average + speed: fixed %.1f, float %.1f per call\n", (double)fixedTime / rounds, (double)floatTime / rounds);
+}
+
+static void timeThreshold(StepDetector& d) {
+  const int rounds = 1000000;
+  uint32_t start = STEP_DETECTOR_CYCLES();
+  for (int i = 0; i < rounds; i++) sink += StepDetectorProbe::stepCondition(d, (int16_t)(i + 1), (int16_t)i, (i * 7) & 0x7FFF);
+  uint32_t fixedTime = STEP_DETECTOR_CYCLES() - start;
+  start = STEP_DETECTOR_CYCLES();
+  for (int i = 0; i < rounds; i++) sink += floatStepCondition((int16_t)(i + 1), (int16_t)i, (int16_t)((i * 7) & 0x3FFF), (int16_t)((i * 7) & 0x3FFF) - 1);
+  uint32_t floatTime = STEP_DETECTOR_CYCLES() - start;
+  printf("timing, step threshold:  fixed %.1f, float %.1f per call\n", (double)fixedTime / rounds, (double)floatTime / rounds);
+}
+
+int main() {
+  LIS2DH12RegisterFile registers;
+  LIS2DH12 accel(&registers);
+  StepDetector detector(&accel);
+
+  bool ok = checkSpeed(detector);
+  ok = checkThreshold(detector) && ok;
+  timeSpeed(detector);
+  timeThreshold(detector);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#ifndef STEP_TRACE_H
+#define STEP_TRACE_H
+
+// Recorded accelerometer traces for the host tools, not part of the Arduino library.
+//
+// CSV, one sample per line: t_us,x,y,z[,step]
+//   x, y, z are the raw OUT_X/Y/Z register words (left-justified, as LIS2DH12Group::getSamples()
+//   returns them), step is 1 on the sample where a labelled pedal stroke completes.
+//   Lines starting with '#' and a non-numeric header line are skipped.
+// Binary capture, little-endian: "SWTR", uint16 version (1), uint16 reserved, uint32 count,
+//   then count records of uint32 t_us, int16 x, int16 y, int16 z, uint16 step.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+struct TraceSample {
+  uint32_t timestampUs;
+  int16_t x, y, z;
+  uint8_t step;   // 1 if a labelled stroke completes on this sample
+};
+
+struct Trace {
+  std::string name;
+  std::vector<TraceSample> samples;
+};
+
+static const char traceMagic[4] = {'S', 'W', 'T', 'R'};
+static const uint16_t traceVersion = 1;
+static const size_t traceHeaderSize = 12;
+static const size_t traceRecordSize = 12;
+
+inline uint16_t traceLoad16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+inline uint32_t traceLoad32(const uint8_t* p) { return traceLoad16(p) | ((uint32_t)traceLoad16(p + 2) << 16); }
+inline void traceStore16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+inline void traceStore32(uint8_t* p, uint32_t v) { traceStore16(p, (uint16_t)v); traceStore16(p + 2, (uint16_t)(v >> 16)); }
+
+// Reads samples incrementally from a trace already in memory (a read or mapped file),
+// so long recordings never need a second copy.
+class TraceReader {
+public:
+  // Returns false with a message if the header is not valid
+  bool open(const char* data, size_t size, std::string& error) {
+    end = data + size;
+    line = 0;
+    binary = size >= traceHeaderSize && memcmp(data, traceMagic, sizeof(traceMagic)) == 0;
+    if (!binary) {
+      cursor = data;
+      return true;
+    }
+    const uint8_t* p = (const uint8_t*)data;
+    if (traceLoad16(p + 4) != traceVersion) {
+      error = "unsupported capture version";
+      return false;
+    }
+    remaining = traceLoad32(p + 8);
+    if ((size - traceHeaderSize) / traceRecordSize < remaining) {
+      error = "truncated capture";
+      return false;
+    }
+    cursor = data + traceHeaderSize;
+    return true;
+  }
+
+  // Up to max samples, 0 at the end of the trace or on a malformed line (then error is set)
+  size_t read(TraceSample* out, size_t max, std::string& error) {
+    size_t n = 0;
+    if (binary) {
+      const uint8_t* p = (const uint8_t*)cursor;
+      for (; n < max && remaining > 0; n++, remaining--, p += traceRecordSize) {
+        out[n].timestampUs = traceLoad32(p);
+        out[n].x = (int16_t)traceLoad16(p + 4);
+        out[n].y = (int16_t)traceLoad16(p + 6);
+        out[n].z = (int16_t)traceLoad16(p + 8);
+        out[n].step = traceLoad16(p + 10) ? 1 : 0;
+      }
+      cursor = (const char*)p;
+      return n;
+    }
+
+    while (n < max && cursor < end) {
+      const char* eol = (const char*)memchr(cursor, '\n', end - cursor);
+      if (eol == NULL) eol = end;
+      line++;
+      // strtol needs a terminated string; lines are short
+      char buffer[128];
+      size_t length = eol - cursor < (ptrdiff_t)sizeof(buffer) - 1 ? eol - cursor : sizeof(buffer) - 1;
+      memcpy(buffer, cursor, length);
+      buffer[length] = '\0';
+      cursor = eol + 1;
+
+      char* p = buffer;
+      while (*p == ' ' || *p == '\t') p++;
+      if (*p == '#' || *p == '\r' || *p == '\0') continue;
+      if (line == 1 && !(*p >= '0' && *p <= '9')) continue;   // Header line
+
+      long fields[5] = {0, 0, 0, 0, 0};
+      int count = 0;
+      while (count < 5) {
+        char* next;
+        fields[count] = strtol(p, &next, 10);
+        if (next == p) break;
+        count++;
+        p = next;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p != ',') break;
+        p++;
+      }
+      if (count < 4) {
+        error = "line " + std::to_string(line) + ": expected t_us,x,y,z[,step]";
+        cursor = end;
+        return 0;
+      }
+      out[n].timestampUs = (uint32_t)fields[0];
+      out[n].x = (int16_t)fields[1];
+      out[n].y = (int16_t)fields[2];
+      out[n].z = (int16_t)fields[3];
+      out[n].step = fields[4] ? 1 : 0;
+      n++;
+    }
+    return n;
+  }
+
+private:
+  const char* end;
+  const char* cursor;
+  bool binary;
+  uint32_t remaining;   // Records left in a binary capture
+  size_t line;          // CSV line number, for messages
+};
+
+// Parses a whole trace already in memory. Returns false with a message on error.
+inline bool parseTrace(const char* data, size_t size, Trace& trace, std::string& error) {
+  trace.samples.clear();
+  TraceReader reader;
+  if (!reader.open(data, size, error)) return false;
+  TraceSample chunk[256];
+  size_t n;
+  while ((n = reader.read(chunk, 256, error)) > 0) {
+    trace.samples.insert(trace.samples.end(), chunk, chunk + n);
+  }
+  return error.empty();
+}
+
+inline bool loadTrace(const char* path, Trace& trace, std::string& error) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    error = std::string("cannot open ") + path;
+    return false;
+  }
+  std::string data;
+  char chunk[65536];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) data.append(chunk, n);
+  fclose(file);
+
+  trace.name = path;
+  if (!parseTrace(data.data(), data.size(), trace, error)) {
+    error = std::string(path) + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+// Writes the binary capture format when the path ends in .bin, CSV otherwise
+inline bool saveTrace(const char* path, const Trace& trace) {
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) return false;
+  size_t length = strlen(path);
+  bool binary = length > 4 && strcmp(path + length - 4, ".bin") == 0;
+  if (binary) {
+    uint8_t header[traceHeaderSize] = {0};
+    memcpy(header, traceMagic, sizeof(traceMagic));
+    traceStore16(header + 4, traceVersion);
+    traceStore32(header + 8, (uint32_t)trace.samples.size());
+    fwrite(header, 1, sizeof(header), file);
+    for (const TraceSample& s : trace.samples) {
+      uint8_t record[traceRecordSize];
+      traceStore32(record, s.timestampUs);
+      traceStore16(record + 4, (uint16_t)s.x);
+      traceStore16(record + 6, (uint16_t)s.y);
+      traceStore16(record + 8, (uint16_t)s.z);
+      traceStore16(record + 10, s.step);
+      fwrite(record, 1, sizeof(record), file);
+    }
+  } else {
+    fprintf(file, "t_us,x,y,z,step\n");
+    for (const TraceSample& s : trace.samples) {
+      fprintf(file, "%lu,%d,%d,%d,%d\n", (unsigned long)s.timestampUs, s.x, s.y, s.z, s.step);
+    }
+  }
+  return fclose(file) == 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef TRACE_SENSOR_H
+#define TRACE_SENSOR_H
+
+// Emulated LIS2DH12 playing back a trace for the host tools.
+// The chip converts at the rate and in the mode the detector configures, and holds whatever the
+// trace shows at each conversion, so a ride recorded at 200 Hz goes through the same idle and
+// active profiles as on the bike. The group clock is the trace time.
+
+#include <LIS2DH12.h>
+#include <LIS2DH12Group.h>
+#include "Trace.h"
+
+class TraceSensor {
+public:
+  TraceSensor() : accel(&registers), group(clock) { group.addDevice(&accel); }
+
+  LIS2DH12Group* getGroup() { return &group; }
+  LIS2DH12* getDevice() { return &accel; }
+
+  // Samples must arrive in time order. onTick(timeUs) runs after each conversion, with the
+  // new sample readable and the clock at the conversion time.
+  template <class Tick>
+  void feed(const TraceSample& s, Tick onTick) {
+    if (!started) {
+      nextTickUs = s.timestampUs;
+      started = true;
+    } else {
+      while ((int32_t)(s.timestampUs - nextTickUs) > 0) convert(onTick);
+    }
+    held = s;
+  }
+
+  // Conversions up to and including the time of the last sample fed
+  template <class Tick>
+  void finish(Tick onTick) {
+    while (started && (int32_t)(held.timestampUs - nextTickUs) >= 0) convert(onTick);
+  }
+
+  // Conversions so far
+  size_t getSamples() const { return samples; }
+
+private:
+  LIS2DH12RegisterFile registers;
+  LIS2DH12 accel;
+  LIS2DH12Group group;
+  TraceSample held;
+  bool started = false;
+  uint32_t nextTickUs = 0;
+  size_t samples = 0;
+
+  // One clock per thread, so sessions can be replayed in parallel
+  static uint32_t& now() {
+    static thread_local uint32_t timeUs;
+    return timeUs;
+  }
+  static uint32_t clock(void) { return now(); }
+
+  // Output register word as the chip reports it in each mode: 8, 10 or 12 bits, left-justified
+  static int16_t quantize(int16_t v, uint8_t mode) {
+    switch (mode) {
+      case LIS2DH12::LOW_POWER_MODE: return (int16_t)(v & 0xFF00);
+      case LIS2DH12::NORMAL_MODE: return (int16_t)(v & 0xFFC0);
+      default: return (int16_t)(v & 0xFFF0);
+    }
+  }
+
+  template <class Tick>
+  void convert(Tick onTick) {
+    registers.pushSample(quantize(held.x, accel.mode), quantize(held.y, accel.mode), quantize(held.z, accel.mode));
+    now() = nextTickUs;
+    samples++;
+    onTick(nextTickUs);
+    // The detector may have switched between the idle and active rate
+    uint16_t rate = accel.getAcquireRate();
+    nextTickUs += 1000000UL / (rate ? rate : 1);
+  }
+};
+
+#endif
@@ -0,0 +1,346 @@
+// Offline replay of accelerometer traces through StepDetector on the host.
+// Each trace is fed to an emulated LIS2DH12 (TraceSensor.h) that follows the rate and resolution
+// the detector configures, the way the real chip would sample the ride. Detected steps and
+// getBikeSpeed() are scored against the labelled strokes, and checked against a baseline.
+//
+// Build and run on Linux, from this directory:
+//   g++ -std=gnu++17 -O2 -I../../../LIS2DH12 -I../.. step_replay.cpp
+//     ../../../LIS2DH12/*.cpp ../../StepDetector.cpp -o step_replay
+//   ./step_replay --baseline baseline.txt
+//
+// Usage: step_replay [options] [trace.csv|trace.bin ...]
+//   Without traces the built-in synthetic rides are replayed; recordings are added as arguments.
+//   --tolerance MS          Largest distance between a detection and its labelled stroke (150)
+//   --baseline FILE         Fail if a trace scores worse than recorded in FILE
+//   --write-baseline FILE   Record the results of this run
+//   --synth NAME FILE       Write a built-in ride as a trace (.bin for the binary format)
+//   --stats                 Replay with Config::instrumentation and print the detector's counters and call timing
+//
+// Exit status: 0 on success, 1 on a regression, 2 on bad arguments or unreadable input.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <StepDetector.h>
+#include "Trace.h"
+#include "TraceSensor.h"
+
+// Allowed slack against the baseline before a trace counts as regressed
+static const double precisionSlack = 0.01;
+static const double recallSlack = 0.01;
+static const double cadenceSlackRpm = 1.0;
+static const double latencySlackMs = 20.0;
+
+struct ReplayResult {
+  size_t labelled, detected, truePositives;
+  double precision, recall;
+  double cadenceErrorRpm, cadenceErrorMaxRpm;   // getBikeSpeed() against the labelled cadence
+  double latencyMeanMs, latencyMaxMs;           // Detection time minus labelled stroke time
+  size_t samples;                               // Samples the emulated sensor produced
+  double samplesPerSecond;
+  StepDetectorStats stats;   // Filled with --stats
+};
+
+// The default profile with getStats() collecting, for --stats
+struct StatsConfig : StepDetectorConfig {
+  static constexpr bool instrumentation = true;
+};
+
+static double speedToRpm(double kmh) {
+  // Inverse of mapIntervalToSpeed(): km/h = rpm * wheel (mm) * 60 / 1e6
+  return kmh * 1e6 / (60.0 * StepDetectorConfig::wheelDistanceMm);
+}
+
+// Cadence an ideal detector with the same interval averaging shows after labelled stroke i, 0 if none
+static double labelledCadenceRpm(const std::vector<uint32_t>& strokes, size_t i) {
+  const size_t window = StepDetectorConfig::intervalWindowSize;
+  if (i < window) return 0;
+  double sumMs = 0;
+  for (size_t k = i - window + 1; k <= i; k++) {
+    double intervalMs = (strokes[k] - strokes[k - 1]) / 1000.0;
+    if (intervalMs < StepDetectorConfig::minStepInterval || intervalMs > StepDetectorConfig::maxStepInterval) return 0;
+    sumMs += intervalMs;
+  }
+  return 60000.0 * window / sumMs;
+}
+
+template <class Detector>
+static ReplayResult replay(const Trace& trace, uint32_t toleranceUs) {
+  ReplayResult r = {};
+  const std::vector<TraceSample>& in = trace.samples;
+  if (in.empty()) return r;
+
+  std::vector<uint32_t> strokes;
+  for (const TraceSample& s : in) {
+    if (s.step) strokes.push_back(s.timestampUs);
+  }
+
+  TraceSensor sensor;
+  std::unique_ptr<Detector> detector(new Detector(sensor.getGroup()));
+  detector->begin();
+
+  std::vector<uint32_t> detections;
+  size_t nextCheck = 1;   // Cadence is compared halfway between strokes nextCheck and nextCheck + 1
+  double cadenceErrorSum = 0;
+  size_t cadenceChecks = 0;
+
+  auto onTick = [&](uint32_t tick) {
+    if (detector->detectStep()) detections.push_back(tick);
+
+    while (nextCheck + 1 < strokes.size() &&
+           (int32_t)(tick - (strokes[nextCheck] + (strokes[nextCheck + 1] - strokes[nextCheck]) / 2)) >= 0) {
+      double expected = labelledCadenceRpm(strokes, nextCheck);
+      if (expected > 0) {
+        double error = fabs(speedToRpm(detector->getBikeSpeed()) - expected);
+        cadenceErrorSum += error;
+        if (error > r.cadenceErrorMaxRpm) r.cadenceErrorMaxRpm = error;
+        cadenceChecks++;
+      }
+      nextCheck++;
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (const TraceSample& s : in) sensor.feed(s, onTick);
+  sensor.finish(onTick);
+  r.samples = sensor.getSamples();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  r.samplesPerSecond = seconds > 0 ? r.samples / seconds : 0;
+  r.stats = detector->getStats();
+
+  // Greedy in-order matching: each stroke takes the first detection within the tolerance
+  double latencySum = 0;
+  size_t next = 0;
+  for (uint32_t d : detections) {
+    while (next < strokes.size() && (int64_t)strokes[next] + toleranceUs < (int64_t)d) next++;
+    if (next < strokes.size() && (int64_t)strokes[next] <= (int64_t)d + toleranceUs) {
+      double latencyMs = ((int64_t)d - (int64_t)strokes[next]) / 1000.0;
+      latencySum += latencyMs;
+      if (r.truePositives == 0 || latencyMs > r.latencyMaxMs) r.latencyMaxMs = latencyMs;
+      r.truePositives++;
+      next++;
+    }
+  }
+
+  r.labelled = strokes.size();
+  r.detected = detections.size();
+  r.precision = r.detected ? (double)r.truePositives / r.detected : 1.0;
+  r.recall = r.labelled ? (double)r.truePositives / r.labelled : 1.0;
+  r.latencyMeanMs = r.truePositives ? latencySum / r.truePositives : 0;
+  r.cadenceErrorRpm = cadenceChecks ? cadenceErrorSum / cadenceChecks : 0;
+  return r;
+}
+
+// Built-in rides: a crank-mounted sensor at 200 Hz, gravity turning in the x/y plane plus pedal
+// load and noise, rest at both ends. Strokes are labelled where x falls through its midpoint.
+struct Segment {
+  float seconds;
+  float startRpm, endRpm;   // 0 for standing still
+};
+
+struct Ride {
+  const char* name;
+  Segment segments[4];
+};
+
+static const Ride builtinRides[] = {
+  {"steady-60", {{2, 0, 0}, {40, 60, 60}, {3, 0, 0}}},
+  {"steady-100", {{2, 0, 0}, {40, 100, 100}, {3, 0, 0}}},
+  {"ramp-45-120", {{2, 0, 0}, {60, 45, 120}, {3, 0, 0}}},
+  {"stop-and-go", {{2, 0, 0}, {20, 80, 80}, {8, 0, 0}, {20, 70, 90}}},
+};
+
+static Trace synthesize(const Ride& ride) {
+  Trace trace;
+  trace.name = ride.name;
+  const double rateHz = 200;
+  const double gravity = 16384;   // 1 g at +-2 g full scale
+  double phase = 0;               // Crank angle in turns
+  double t = 0;
+  uint32_t seed = 12345;
+  for (const Segment& segment : ride.segments) {
+    size_t count = (size_t)(segment.seconds * rateHz);
+    for (size_t i = 0; i < count; i++) {
+      double rpm = segment.startRpm + (segment.endRpm - segment.startRpm) * i / count;
+      bool moving = rpm > 0;
+      double previous = phase;
+      if (moving) phase += rpm / 60.0 / rateHz;
+      double angle = 2 * M_PI * phase;
+      // The midpoint of x = g cos(angle) falls through zero at a quarter turn
+      bool stroke = moving && floor(previous - 0.25) != floor(phase - 0.25);
+
+      int noise[3];
+      for (int k = 0; k < 3; k++) {
+        seed = seed * 1103515245 + 12345;
+        noise[k] = (int)((seed >> 16) % 601) - 300;
+      }
+      double load = moving ? 1500 * sin(2 * angle) : 0;
+      TraceSample s;
+      s.timestampUs = (uint32_t)llround(t * 1e6);
+      s.x = (int16_t)lrint((moving ? gravity * cos(angle) : gravity) + noise[0]);
+      s.y = (int16_t)lrint((moving ? gravity * sin(angle) : 0) + load + noise[1]);
+      s.z = (int16_t)lrint(1500 + noise[2]);
+      s.step = stroke ? 1 : 0;
+      trace.samples.push_back(s);
+      t += 1 / rateHz;
+    }
+  }
+  return trace;
+}
+
+static const Ride* findRide(const char* name) {
+  for (const Ride& ride : builtinRides) {
+    if (strcmp(ride.name, name) == 0) return &ride;
+  }
+  return NULL;
+}
+
+// Baseline: one line per trace, name precision recall cadence-error-rpm mean-latency-ms
+static std::map<std::string, ReplayResult> readBaseline(const char* path, bool& ok) {
+  std::map<std::string, ReplayResult> baseline;
+  FILE* file = fopen(path, "r");
+  ok = file != NULL;
+  if (!ok) return baseline;
+  char line[512];
+  while (fgets(line, sizeof(line), file)) {
+    if (line[0] == '#') continue;
+    char name[400];
+    ReplayResult r = {};
+    if (sscanf(line, "%399s %lf %lf %lf %lf", name, &r.precision, &r.recall, &r.cadenceErrorRpm, &r.latencyMeanMs) == 5) {
+      baseline[name] = r;
+    }
+  }
+  fclose(file);
+  return baseline;
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: step_replay [--tolerance MS] [--baseline FILE] [--write-baseline FILE] [--stats] [trace ...]\n"
+                  "       step_replay --synth NAME FILE\n");
+}
+
+int main(int argc, char** argv) {
+  uint32_t toleranceUs = 150000;
+  const char* baselinePath = NULL;
+  const char* writeBaselinePath = NULL;
+  bool printStats = false;
+  std::vector<const char*> paths;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      toleranceUs = (uint32_t)(atof(argv[++i]) * 1000);
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baselinePath = argv[++i];
+    } else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc) {
+      writeBaselinePath = argv[++i];
+    } else if (strcmp(argv[i], "--stats") == 0) {
+      printStats = true;
+    } else if (strcmp(argv[i], "--synth") == 0 && i + 2 < argc) {
+      const Ride* ride = findRide(argv[i + 1]);
+      if (ride == NULL) {
+        fprintf(stderr, "unknown ride %s\n", argv[i + 1]);
+        return 2;
+      }
+      if (!saveTrace(argv[i + 2], synthesize(*ride))) {
+        fprintf(stderr, "cannot write %s\n", argv[i + 2]);
+        return 2;
+      }
+      return 0;
+    } else if (argv[i][0] == '-') {
+      usage();
+      return 2;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+
+  std::vector<Trace> traces;
+  if (paths.empty()) {
+    for (const Ride& ride : builtinRides) traces.push_back(synthesize(ride));
+  }
+  for (const char* path : paths) {
+    Trace trace;
+    std::string error;
+    if (!loadTrace(path, trace, error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 2;
+    }
+    traces.push_back(trace);
+  }
+
+  std::map<std::string, ReplayResult> baseline;
+  if (baselinePath) {
+    bool ok;
+    baseline = readBaseline(baselinePath, ok);
+    if (!ok) {
+      fprintf(stderr, "cannot read %s\n", baselinePath);
+      return 2;
+    }
+  }
+  FILE* record = NULL;
+  if (writeBaselinePath) {
+    record = fopen(writeBaselinePath, "w");
+    if (record == NULL) {
+      fprintf(stderr, "cannot write %s\n", writeBaselinePath);
+      return 2;
+    }
+    fprintf(record, "# trace precision recall cadence-error-rpm latency-ms\n");
+  }
+
+  printf("%-24s %7s %7s %9s %9s %9s %9s %10s\n", "trace", "strokes", "steps", "precision", "recall",
+         "cad.err", "latency", "samples/s");
+  int regressions = 0;
+  for (const Trace& trace : traces) {
+    ReplayResult r = printStats ? replay<BasicStepDetector<StatsConfig> >(trace, toleranceUs)
+                                : replay<StepDetector>(trace, toleranceUs);
+    printf("%-24s %7zu %7zu %9.3f %9.3f %6.2frpm %7.1fms %10.0f\n", trace.name.c_str(), r.labelled, r.detected,
+           r.precision, r.recall, r.cadenceErrorRpm, r.latencyMeanMs, r.samplesPerSecond);
+    if (printStats) {
+      const StepDetectorStats& st = r.stats;
+      printf("  calls=%lu samples=%lu lost=%lu overruns=%lu accepted=%lu rejected=%lu\n  ns/call:",
+             (unsigned long)st.calls, (unsigned long)st.samples, (unsigned long)st.lostSamples,
+             (unsigned long)st.overruns, (unsigned long)st.stepsAccepted, (unsigned long)st.stepsRejected);
+      for (size_t k = 0; k < sizeof(st.callCycles.buckets) / sizeof(st.callCycles.buckets[0]); k++) {
+        if (st.callCycles.buckets[k]) printf(" <%lu:%lu", 2UL << k, (unsigned long)st.callCycles.buckets[k]);
+      }
+      printf("\n");
+    }
+    if (record) {
+      fprintf(record, "%s %.4f %.4f %.3f %.1f\n", trace.name.c_str(), r.precision, r.recall, r.cadenceErrorRpm,
+              r.latencyMeanMs);
+    }
+
+    std::map<std::string, ReplayResult>::const_iterator it = baseline.find(trace.name);
+    if (it == baseline.end()) continue;
+    const ReplayResult& b = it->second;
+    if (r.precision < b.precision - precisionSlack) {
+      printf("  REGRESSION precision %.3f < %.3f\n", r.precision, b.precision);
+      regressions++;
+    }
+    if (r.recall < b.recall - recallSlack) {
+      printf("  REGRESSION recall %.3f < %.3f\n", r.recall, b.recall);
+      regressions++;
+    }
+    if (r.cadenceErrorRpm > b.cadenceErrorRpm + cadenceSlackRpm) {
+      printf("  REGRESSION cadence error %.2f > %.2f rpm\n", r.cadenceErrorRpm, b.cadenceErrorRpm);
+      regressions++;
+    }
+    if (r.latencyMeanMs > b.latencyMeanMs + latencySlackMs) {
+      printf("  REGRESSION latency %.1f > %.1f ms\n", r.latencyMeanMs, b.latencyMeanMs);
+      regressions++;
+    }
+  }
+  if (record) fclose(record);
+
+  if (regressions) {
+    printf("%d regression(s)\n", regressions);
+    return 1;
+  }
+  return 0;
+}
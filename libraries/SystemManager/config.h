@@ -9,6 +9,7 @@
 #define VOLUME_UP_GPIO          1   // GPIO for Volume Up button
 #define VOLUME_DOWN_GPIO        5   // GPIO for Volume Down button
 #define LOCK_BUTTON_GPIO        6   // GPIO for Lock button
+#define ACCEL_INT1_GPIO        -1   // GPIO wired to LIS2DH12 INT1, -1 to poll the sensor instead
 
 #define PWM_CHANNEL 0  
 #define PWM_FREQ 25000 
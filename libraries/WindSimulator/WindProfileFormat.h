@@ -0,0 +1,83 @@
+#ifndef WIND_PROFILE_FORMAT_H
+#define WIND_PROFILE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compact wind profile, little-endian, shared by WindProfileSource and extras/wind_encode.cpp.
+//
+//   header   WIND_PROFILE_HEADER_SIZE bytes, see WindProfileHeader
+//   index    blockCount uint32 byte offsets of each block, from the start of the data
+//   data     the samples, blockSize per block
+//
+// A sample is an integer q; its value is offsetQ16 + q * scaleQ16 in km/h * 65536.
+// WIND_ENCODING_QUANT8: one byte per sample, q = 0..255.
+// WIND_ENCODING_DELTA: each block starts with zig-zag varint q, then zig-zag varint q - previous q.
+// WIND_ENCODING_RICE: each block starts with zig-zag varint q and a parameter byte (Rice shift k
+//   in bits 0..4, WIND_RICE_SECOND_ORDER), then one Rice code per remaining sample, packed LSB
+//   first and padded to a byte at the end of the block. A code is the zig-zag residual r as
+//   r >> k ones, a zero, then the k low bits of r. The residual is q - previous q, or with
+//   WIND_RICE_SECOND_ORDER q - (2 * previous q - the one before), from the block's third sample on.
+//   The encoder picks k and the predictor per block, so smooth data costs a few bits per sample.
+// Blocks let a reader seek anywhere by decoding at most blockSize - 1 samples.
+
+#define WIND_PROFILE_MAGIC "WNDP"
+#define WIND_PROFILE_VERSION 1
+#define WIND_PROFILE_HEADER_SIZE 28
+
+enum WindEncoding {
+  WIND_ENCODING_QUANT8 = 0,
+  WIND_ENCODING_DELTA = 1,
+  WIND_ENCODING_RICE = 2
+};
+
+#define WIND_RICE_SHIFT_MASK 0x1F
+#define WIND_RICE_SECOND_ORDER 0x80
+
+struct WindProfileHeader {
+  uint8_t encoding;
+  uint16_t intervalMs;    // Time between samples
+  uint32_t sampleCount;
+  int32_t offsetQ16;      // km/h * 65536 of q = 0
+  uint32_t scaleQ16;      // km/h * 65536 per step of q
+  uint16_t blockSize;     // Samples per index entry
+  uint32_t blockCount;
+};
+
+inline uint16_t windLoad16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+inline uint32_t windLoad32(const uint8_t* p) { return windLoad16(p) | ((uint32_t)windLoad16(p + 2) << 16); }
+inline void windStore16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+inline void windStore32(uint8_t* p, uint32_t v) { windStore16(p, (uint16_t)v); windStore16(p + 2, (uint16_t)(v >> 16)); }
+
+// Layout: magic[4], version u8, encoding u8, intervalMs u16, sampleCount u32, offsetQ16 i32,
+// scaleQ16 u32, blockSize u16, reserved u16, blockCount u32
+inline bool windParseHeader(const uint8_t* p, WindProfileHeader* h) {
+  if (p[0] != 'W' || p[1] != 'N' || p[2] != 'D' || p[3] != 'P' || p[4] != WIND_PROFILE_VERSION) return false;
+  h->encoding = p[5];
+  h->intervalMs = windLoad16(p + 6);
+  h->sampleCount = windLoad32(p + 8);
+  h->offsetQ16 = (int32_t)windLoad32(p + 12);
+  h->scaleQ16 = windLoad32(p + 16);
+  h->blockSize = windLoad16(p + 20);
+  h->blockCount = windLoad32(p + 24);
+  if (h->encoding > WIND_ENCODING_RICE || h->blockSize == 0 || h->intervalMs == 0) return false;
+  return h->blockCount == (h->sampleCount + h->blockSize - 1) / h->blockSize;
+}
+
+inline void windWriteHeader(uint8_t* p, const WindProfileHeader* h) {
+  p[0] = 'W'; p[1] = 'N'; p[2] = 'D'; p[3] = 'P';
+  p[4] = WIND_PROFILE_VERSION;
+  p[5] = h->encoding;
+  windStore16(p + 6, h->intervalMs);
+  windStore32(p + 8, h->sampleCount);
+  windStore32(p + 12, (uint32_t)h->offsetQ16);
+  windStore32(p + 16, h->scaleQ16);
+  windStore16(p + 20, h->blockSize);
+  windStore16(p + 22, 0);
+  windStore32(p + 24, h->blockCount);
+}
+
+inline uint32_t windZigZag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t windUnZigZag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+#endif
@@ -1,23 +1,188 @@
 #include "WindSimulator.h"
 
-WindSimulator::WindSimulator(const float* windData, int dataSize) {
-  windSpeed = (windData && dataSize > 0) ? windData : nullptr;
-  arraySize = (windData && dataSize > 0) ? dataSize : 0;
-  naturalWindMillis = millis();
-  currentNaturalWindSpeed = arraySize > 0 ? windSpeed[0] : 0.0f;
+WindSimulator::WindSimulator(const float* windData, int dataSize)
+  : arraySource(windData, dataSize > 0 ? dataSize : 0), source(&arraySource) {
+  segmentMillis = millis();
+  // An array is in RAM, so the first block can be had right away
+  while (backCount < BLOCK_SIZE && source->size() > 0) readAhead();
+  advance();
+}
+
+WindSimulator::WindSimulator(WindSource* source) : source(source) {
+  segmentMillis = millis();
+}
+
+bool WindSimulator::setSource(WindSource* newSource) {
+  // An empty or unreadable profile would never fill a block and the wind would freeze
+  if (!newSource || newSource->size() == 0) return false;
+  if (!pendingSource) {
+    // First sample not yet in the front block, which the read-ahead may have wrapped past
+    uint32_t size = source ? source->size() : 0;
+    resumeIndex = backIndex >= backCount ? backIndex - backCount : backIndex + size - backCount;
+  }
+  // Drop what was read ahead of the old profile, the front block keeps playing meanwhile
+  pendingSource = newSource;
+  backCount = 0;
+  backIndex = 0;
+  loadFailures = 0;
+  return true;
 }
 
 void WindSimulator::update() {
-  if (!windSpeed || arraySize == 0) return;
-  
+  readAhead();
+
   unsigned long currentMillis = millis();
-  if (currentMillis - naturalWindMillis >= UPDATE_INTERVAL) {
-    naturalWindMillis = currentMillis;
-    currentNaturalWindSpeed = windSpeed[ind];
-    ind = (ind + 1) % arraySize;
+  if (currentMillis - segmentMillis >= sampleInterval) {
+    segmentMillis = currentMillis;
+    advance();
   }
 }
 
+void WindSimulator::readAhead() {
+  WindSource* target = pendingSource ? pendingSource : source;
+  if (!target || backCount == BLOCK_SIZE) return;
+  uint32_t size = target->size();
+  size_t got = 0;
+  if (size > 0) {
+    if (backIndex >= size) backIndex = 0;  // Profiles loop
+    uint32_t n = BLOCK_SIZE - backCount;
+    if (n > READ_CHUNK) n = READ_CHUNK;
+    if (n > size - backIndex) n = size - backIndex;
+    got = target->read(backIndex, &buffers[front ^ 1][backCount], n);
+    backCount += got;
+    backIndex += got;
+  }
+
+  if (target != pendingSource) return;
+  if (got > 0) {
+    loadFailures = 0;
+  } else if (++loadFailures >= MAX_LOAD_FAILURES) {
+    // Give up on the new profile and read ahead the current one again
+    pendingSource = nullptr;
+    backCount = 0;
+    backIndex = resumeIndex;
+  }
+}
+
+void WindSimulator::advance() {
+  if (!primed) {
+    int16_t first;
+    if (!nextSample(&first)) {
+      underruns++;
+      return;
+    }
+    // Start on the first sample instead of ramping up from zero
+    history[0] = history[1] = history[2] = first;
+    nextSample(&history[2]);
+    history[3] = history[2];
+    nextSample(&history[3]);
+    primed = true;
+    updateInterval();
+  } else {
+    history[0] = history[1];
+    history[1] = history[2];
+    history[2] = history[3];
+    if (!nextSample(&history[3])) underruns++;  // Last sample is held
+  }
+  prepareSegment();
+}
+
+bool WindSimulator::nextSample(int16_t* sample) {
+  if (pendingSource) {
+    if (backCount < BLOCK_SIZE) {
+      // Keep the old profile going while the new one loads
+      if (frontPos >= frontCount) return false;
+      *sample = buffers[front][frontPos++];
+      return true;
+    }
+    source = pendingSource;
+    pendingSource = nullptr;
+    swapBuffers();
+    updateInterval();
+  } else if (frontPos >= frontCount) {
+    if (backCount < BLOCK_SIZE) return false;
+    swapBuffers();
+  }
+  *sample = buffers[front][frontPos++];
+  return true;
+}
+
+void WindSimulator::swapBuffers() {
+  front ^= 1;
+  frontCount = backCount;
+  frontPos = 0;
+  backCount = 0;
+}
+
+void WindSimulator::updateInterval() {
+  uint16_t interval = source ? source->getIntervalMs() : 0;
+  sampleInterval = interval > 0 ? interval : DEFAULT_INTERVAL;
+}
+
+// Slope at a sample for the monotone cubic: flat at a peak or valley, otherwise the harmonic
+// mean of the neighbouring differences, which keeps the curve between the samples (Fritsch-Butland)
+static int32_t monotoneSlope(int32_t before, int32_t after) {
+  if (before == 0 || after == 0 || (before > 0) != (after > 0)) return 0;
+  return (int32_t)(2 * (int64_t)before * after / (before + after));
+}
+
+// Coefficients are worked out once per sample so a query is only a few integer multiplies
+void WindSimulator::prepareSegment() {
+  int32_t d0 = history[1] - history[0];
+  int32_t d1 = history[2] - history[1];
+  int32_t d2 = history[3] - history[2];
+  int32_t m1, m2;  // Slopes at both ends of the segment, Q8 per interval
+
+  switch (interpolation) {
+    case WIND_INTERPOLATION_LINEAR:
+      coeff[0] = d1;
+      coeff[1] = coeff[2] = 0;
+      return;
+    case WIND_INTERPOLATION_MONOTONE_CUBIC:
+      m1 = monotoneSlope(d0, d1);
+      m2 = monotoneSlope(d1, d2);
+      break;
+    case WIND_INTERPOLATION_CATMULL_ROM:
+      m1 = (d0 + d1) / 2;
+      m2 = (d1 + d2) / 2;
+      break;
+    default:
+      coeff[0] = coeff[1] = coeff[2] = 0;
+      return;
+  }
+  // Cubic Hermite between history[1] and history[2]
+  coeff[0] = m1;
+  coeff[1] = 3 * d1 - 2 * m1 - m2;
+  coeff[2] = m1 + m2 - 2 * d1;
+}
+
+void WindSimulator::setInterpolation(WindInterpolation mode) {
+  interpolation = mode;
+  prepareSegment();
+}
+
 float WindSimulator::getNaturalWindSpeed() {
-  return currentNaturalWindSpeed;
-}
\ No newline at end of file
+  return getNaturalWindSpeedQ8(millis()) / 256.0f;
+}
+
+float WindSimulator::getNaturalWindSpeed(unsigned long atMillis) {
+  return getNaturalWindSpeedQ8(atMillis) / 256.0f;
+}
+
+int16_t WindSimulator::getNaturalWindSpeedQ8() {
+  return getNaturalWindSpeedQ8(millis());
+}
+
+int16_t WindSimulator::getNaturalWindSpeedQ8(unsigned long atMillis) {
+  long elapsed = (long)(atMillis - segmentMillis);
+  if (elapsed <= 0) return history[1];
+  // Late update(): stay at the end of the segment rather than extrapolating
+  if (elapsed > sampleInterval) elapsed = sampleInterval;
+
+  int64_t t = ((uint32_t)elapsed << 16) / sampleInterval;  // Position in the segment, Q16
+  const int64_t half = 1 << 15;  // Round each step, flooring would pull falling segments below their end
+  int64_t v = (((((coeff[2] * t + half) >> 16) + coeff[1]) * t + half) >> 16) + coeff[0];
+  v = history[1] + ((v * t + half) >> 16);
+  if (v < 0) return 0;  // Catmull-Rom can dip below a calm spell
+  return v > INT16_MAX ? INT16_MAX : (int16_t)v;
+}
@@ -2,20 +2,66 @@
 #define WIND_SIMULATOR_H
 
 #include <Arduino.h>
+#include "WindSource.h"
+
+// How the wind moves from one profile sample to the next
+enum WindInterpolation {
+  WIND_INTERPOLATION_NONE,            // Hold each sample for its whole interval
+  WIND_INTERPOLATION_LINEAR,
+  WIND_INTERPOLATION_MONOTONE_CUBIC,  // Smooth, never overshoots the samples
+  WIND_INTERPOLATION_CATMULL_ROM      // Smoothest, may overshoot around sharp changes
+};
 
 class WindSimulator {
 public:
   WindSimulator(const float* windData, int dataSize); // Pass array and size
+  WindSimulator(WindSource* source);                  // Stream from a file or other source
   void update();
-  float getNaturalWindSpeed();
+  float getNaturalWindSpeed();                        // At millis()
+  // At any millis() time in the current sample interval; earlier or later times clamp to its ends
+  float getNaturalWindSpeed(unsigned long atMillis);
+  int16_t getNaturalWindSpeedQ8();                    // km/h * 256, integer maths only
+  int16_t getNaturalWindSpeedQ8(unsigned long atMillis);
+  void setInterpolation(WindInterpolation mode);      // Linear by default
+  // Switch profile. The current one keeps playing until the first block of the new one is read,
+  // a few samples per update(), so update() never waits for it. Returns false, and keeps the
+  // current profile, for a source without samples; one that fails while loading is dropped too.
+  bool setSource(WindSource* source);
+  uint32_t getUnderruns() { return underruns; }       // Ticks that found no sample ready (value held)
 
 private:
-  const float* windSpeed;               // Pointer to external array
-  int arraySize;                        // Runtime size of array
-  int ind = 0;
-  unsigned long naturalWindMillis = 0;
-  float currentNaturalWindSpeed = 0.0f;
-  const unsigned long UPDATE_INTERVAL = 1000;
+  static const uint8_t BLOCK_SIZE = 32;               // Samples per buffer, two buffers in RAM
+  static const uint8_t READ_CHUNK = 8;                // Samples read ahead per update()
+  static const uint16_t DEFAULT_INTERVAL = 1000;      // ms between samples of a source that does not say
+  static const uint8_t MAX_LOAD_FAILURES = 16;        // Reads without progress before a pending source is dropped
+
+  WindArraySource arraySource;
+  WindSource* source;                                 // Profile being played
+  WindSource* pendingSource = nullptr;                // Profile being loaded by setSource()
+  int16_t buffers[2][BLOCK_SIZE];                     // Front block is played while the back one is read ahead
+  uint8_t front = 0;
+  uint8_t frontPos = 0;                               // Next sample of the front block
+  uint8_t frontCount = 0;
+  uint8_t backCount = 0;                              // Samples read ahead so far
+  uint32_t backIndex = 0;                             // Profile index of the next sample to read ahead
+  uint32_t resumeIndex = 0;                           // Where the current profile goes on if the pending one fails
+  uint8_t loadFailures = 0;
+  uint32_t underruns = 0;
+
+  // Played segment runs from history[1] to history[2]; the outer two shape the cubic modes
+  int16_t history[4] = {0, 0, 0, 0};
+  bool primed = false;                                // history holds the start of a profile
+  WindInterpolation interpolation = WIND_INTERPOLATION_LINEAR;
+  int32_t coeff[3] = {0, 0, 0};                       // history[1] + c0 t + c1 t^2 + c2 t^3, Q8
+  unsigned long segmentMillis = 0;                    // When history[1] was reached
+  uint16_t sampleInterval = DEFAULT_INTERVAL;
+
+  void readAhead();
+  void advance();
+  bool nextSample(int16_t* sample);
+  void swapBuffers();
+  void prepareSegment();
+  void updateInterval();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,216 @@
+#include "WindSource.h"
+
+int16_t windToQ8(float kmh) {
+  long q8 = lroundf(kmh * 256.0f);
+  if (q8 > INT16_MAX) return INT16_MAX;
+  if (q8 < 0) return 0;  // Wind has no direction here, negative values are bad data
+  return (int16_t)q8;
+}
+
+size_t WindArraySource::read(uint32_t index, int16_t* out, size_t n) {
+  if (index >= count) return 0;
+  if (n > count - index) n = count - index;
+  for (size_t i = 0; i < n; i++) out[i] = windToQ8(data[index + i]);
+  return n;
+}
+
+bool WindFileSource::open() {
+  if (!opened) {
+    // Only one attempt: a missing file must not cost an open() on every update()
+    opened = true;
+    file = fs.open(path, "r");
+    position = 0;
+  }
+  return (bool)file;
+}
+
+uint32_t WindFileSource::size() {
+  return open() ? file.size() / sizeof(float) : 0;
+}
+
+size_t WindFileSource::read(uint32_t index, int16_t* out, size_t n) {
+  if (!open()) return 0;
+  if (index != position) {
+    if (!file.seek(index * sizeof(float))) return 0;
+    position = index;
+  }
+
+  size_t done = 0;
+  float chunk[16];
+  while (done < n) {
+    size_t want = n - done < 16 ? n - done : 16;
+    size_t got = file.read((uint8_t*)chunk, want * sizeof(float)) / sizeof(float);
+    for (size_t i = 0; i < got; i++) out[done + i] = windToQ8(chunk[i]);
+    done += got;
+    position += got;
+    if (got < want) {
+      // A partial float is left behind; re-seek on the next read
+      position = UINT32_MAX;
+      break;
+    }
+  }
+  return done;
+}
+
+bool WindProfileSource::open() {
+  if (opened) return valid;
+  // Only one attempt, like WindFileSource
+  opened = true;
+  if (fs) {
+    file = fs->open(path, "r");
+    if (!file) return false;
+    length = file.size();
+  }
+  uint8_t raw[WIND_PROFILE_HEADER_SIZE];
+  if (fetch(0, raw, sizeof(raw)) != sizeof(raw) || !windParseHeader(raw, &header)) return false;
+  dataStart = WIND_PROFILE_HEADER_SIZE + header.blockCount * 4;
+  valid = dataStart <= length;
+  return valid;
+}
+
+size_t WindProfileSource::fetch(uint32_t offset, uint8_t* dst, size_t n) {
+  if (offset >= length) return 0;
+  if (n > length - offset) n = length - offset;
+  if (!fs) {
+    memcpy(dst, data + offset, n);
+    return n;
+  }
+  if (file.position() != offset && !file.seek(offset)) return 0;
+  return file.read(dst, n);
+}
+
+bool WindProfileSource::nextByte(uint8_t* b) {
+  if (bytePos - inputStart >= inputLength) {
+    inputStart = bytePos;
+    inputLength = fetch(bytePos, input, INPUT_BUFFER_SIZE);
+    if (inputLength == 0) return false;
+  }
+  *b = input[bytePos++ - inputStart];
+  return true;
+}
+
+bool WindProfileSource::seek(uint32_t index) {
+  uint32_t block = index / header.blockSize;
+  uint8_t entry[4];
+  if (fetch(WIND_PROFILE_HEADER_SIZE + block * 4, entry, 4) != 4) return false;
+  bytePos = dataStart + windLoad32(entry);
+  inputLength = 0;
+  nextIndex = block * header.blockSize;
+  posInBlock = 0;
+
+  uint32_t skip = index - nextIndex;
+  if (header.encoding == WIND_ENCODING_QUANT8) {
+    // Fixed size, no need to decode what is skipped
+    bytePos += skip;
+    nextIndex = index;
+    posInBlock = skip;
+    return true;
+  }
+  int16_t unused;
+  while (nextIndex < index) {
+    if (!decode(&unused)) return false;
+  }
+  return true;
+}
+
+bool WindProfileSource::nextBit(uint8_t* bit) {
+  if (bitsLeft == 0) {
+    if (!nextByte(&bitBuffer)) return false;
+    bitsLeft = 8;
+  }
+  *bit = bitBuffer & 1;
+  bitBuffer >>= 1;
+  bitsLeft--;
+  return true;
+}
+
+bool WindProfileSource::readVarint(uint32_t* v) {
+  uint8_t b;
+  uint8_t shift = 0;
+  *v = 0;
+  do {
+    if (shift > 28 || !nextByte(&b)) return false;
+    *v |= (uint32_t)(b & 0x7F) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return true;
+}
+
+// Quotient in unary, ones ended by a zero, then riceShift low bits
+bool WindProfileSource::readRice(uint32_t* v) {
+  uint8_t bit;
+  uint32_t quotient = 0;
+  for (;;) {
+    if (!nextBit(&bit)) return false;
+    if (!bit) break;
+    quotient++;
+  }
+  uint32_t low = 0;
+  for (uint8_t i = 0; i < riceShift; i++) {
+    if (!nextBit(&bit)) return false;
+    low |= (uint32_t)bit << i;
+  }
+  *v = (quotient << riceShift) | low;
+  return true;
+}
+
+bool WindProfileSource::decode(int16_t* out) {
+  uint32_t v;
+  if (header.encoding == WIND_ENCODING_QUANT8) {
+    uint8_t b;
+    if (!nextByte(&b)) return false;
+    q = b;
+  } else if (posInBlock == 0) {
+    // Every block starts from an absolute value so it can be decoded on its own
+    if (!readVarint(&v)) return false;
+    q = windUnZigZag(v);
+    qPrevious = q;
+    if (header.encoding == WIND_ENCODING_RICE) {
+      uint8_t parameters;
+      if (!nextByte(&parameters)) return false;
+      riceShift = parameters & WIND_RICE_SHIFT_MASK;
+      secondOrder = (parameters & WIND_RICE_SECOND_ORDER) != 0;
+      bitsLeft = 0;
+    }
+  } else if (header.encoding == WIND_ENCODING_DELTA) {
+    if (!readVarint(&v)) return false;
+    q += windUnZigZag(v);
+  } else {
+    if (!readRice(&v)) return false;
+    // qPrevious == q on the second sample, so both predictors start out the same
+    int32_t predicted = secondOrder ? 2 * q - qPrevious : q;
+    qPrevious = q;
+    q = predicted + windUnZigZag(v);
+  }
+  if (++posInBlock == header.blockSize) posInBlock = 0;
+  nextIndex++;
+
+  int64_t valueQ16 = header.offsetQ16 + (int64_t)q * header.scaleQ16;
+  int64_t valueQ8 = (valueQ16 + 128) >> 8;
+  *out = valueQ8 < 0 ? 0 : (valueQ8 > INT16_MAX ? INT16_MAX : (int16_t)valueQ8);
+  return true;
+}
+
+uint32_t WindProfileSource::size() {
+  return open() ? header.sampleCount : 0;
+}
+
+uint16_t WindProfileSource::getIntervalMs() {
+  return open() ? header.intervalMs : 0;
+}
+
+size_t WindProfileSource::read(uint32_t index, int16_t* out, size_t n) {
+  if (!open() || index >= header.sampleCount) return 0;
+  if (n > header.sampleCount - index) n = header.sampleCount - index;
+  if (index != nextIndex && !seek(index)) {
+    nextIndex = UINT32_MAX;
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (!decode(&out[i])) {
+      nextIndex = UINT32_MAX;
+      return i;
+    }
+  }
+  return n;
+}
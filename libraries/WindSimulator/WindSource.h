@@ -0,0 +1,98 @@
+#ifndef WIND_SOURCE_H
+#define WIND_SOURCE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "WindProfileFormat.h"
+
+// Where WindSimulator takes its samples from, in km/h * 256 (Q8).
+// WindSimulator reads a few samples per update() and keeps only two small blocks in RAM,
+// so a source can be as long as the storage behind it.
+class WindSource {
+public:
+  virtual ~WindSource() {}
+  virtual uint32_t size() = 0;                                      // Samples in the profile, 0 if unavailable
+  virtual size_t read(uint32_t index, int16_t* out, size_t count) = 0; // Samples index.., returns how many were read
+  virtual uint16_t getIntervalMs() { return 1000; }                 // Time between samples, 0 if unknown
+};
+
+// Profile compiled into the sketch as a float array (km/h)
+class WindArraySource : public WindSource {
+public:
+  WindArraySource(const float* data = nullptr, uint32_t count = 0) : data(data), count(data ? count : 0) {}
+  uint32_t size() override { return count; }
+  size_t read(uint32_t index, int16_t* out, size_t n) override;
+
+private:
+  const float* data;
+  uint32_t count;
+};
+
+// Profile in a file of little-endian float32 samples (km/h) on LittleFS or any other fs::FS.
+// The file is opened on first use, so the filesystem may be mounted after construction.
+class WindFileSource : public WindSource {
+public:
+  WindFileSource(fs::FS& fs, const char* path) : fs(fs), path(path) {}
+  uint32_t size() override;
+  size_t read(uint32_t index, int16_t* out, size_t n) override;
+
+private:
+  fs::FS& fs;
+  const char* path;
+  fs::File file;
+  bool opened = false;
+  uint32_t position = 0;   // Next sample the file position points at
+
+  bool open();
+};
+
+// Compact profile (WindProfileFormat.h) in a file or in memory, decoded while it is read.
+// Reading on from the last sample continues the decoder; any other index seeks through the
+// block index and decodes at most one block. RAM use is a 32-byte input buffer.
+class WindProfileSource : public WindSource {
+public:
+  WindProfileSource(fs::FS& fs, const char* path) : fs(&fs), path(path) {}
+  WindProfileSource(const uint8_t* data, size_t length) : data(data), length(length) {}
+  uint32_t size() override;
+  size_t read(uint32_t index, int16_t* out, size_t n) override;
+  uint16_t getIntervalMs() override;        // From the header, 0 if the profile is unusable
+
+private:
+  static const uint8_t INPUT_BUFFER_SIZE = 32;
+
+  fs::FS* fs = nullptr;
+  const char* path = nullptr;
+  fs::File file;
+  const uint8_t* data = nullptr;
+  size_t length = 0;
+  bool opened = false;
+  bool valid = false;
+  WindProfileHeader header;
+  uint32_t dataStart = 0;                   // File offset of the first block
+
+  uint32_t nextIndex = UINT32_MAX;          // Sample the decoder produces next
+  uint16_t posInBlock = 0;
+  int32_t q = 0;                            // Last decoded sample
+  int32_t qPrevious = 0;                    // The one before, for the second-order predictor
+  uint8_t riceShift = 0;                    // Rice parameters of the current block
+  bool secondOrder = false;
+  uint8_t bitBuffer = 0;                    // Rice codes not yet consumed from the last byte
+  uint8_t bitsLeft = 0;
+  uint32_t bytePos = 0;                     // File offset of the next encoded byte
+  uint8_t input[INPUT_BUFFER_SIZE];
+  uint32_t inputStart = 0;
+  uint8_t inputLength = 0;
+
+  bool open();
+  size_t fetch(uint32_t offset, uint8_t* dst, size_t n);
+  bool nextByte(uint8_t* b);
+  bool nextBit(uint8_t* bit);
+  bool readVarint(uint32_t* v);
+  bool readRice(uint32_t* v);
+  bool seek(uint32_t index);
+  bool decode(int16_t* out);
+};
+
+int16_t windToQ8(float kmh);  // Saturating conversion of a float sample
+
+#endif
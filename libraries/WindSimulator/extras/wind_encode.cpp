@@ -0,0 +1,230 @@
+// Converts CSV weather data into the compact wind profile format (../WindProfileFormat.h).
+//
+// Build on the host, from this directory:
+//   g++ -std=gnu++17 -O2 -I.. wind_encode.cpp -o wind_encode
+//
+// Usage: wind_encode [options] input.csv output.wnd
+//   --column N          Column holding the wind speed, 0-based (default: last column)
+//   --factor F          Multiply every value, e.g. 3.6 for m/s to km/h (1)
+//   --resolution KMH    Step of rice and delta (0.01); quant8 spreads 256 steps over the range
+//   --encoding E        rice (default), delta or quant8
+//   --interval MS       Time between samples (1000)
+//   --block N           Samples per seek block (256)
+// Lines whose column is not a number (headers, comments) are skipped.
+// Copy the output to LittleFS, e.g. as /wind.wnd, for WindProfileSource.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "WindProfileFormat.h"
+
+static bool parseColumn(char* line, int column, double* value) {
+  std::vector<char*> fields;
+  for (char* field = strtok(line, ",;\t\r\n"); field; field = strtok(NULL, ",;\t\r\n")) fields.push_back(field);
+  if (fields.empty()) return false;
+  int index = column < 0 ? (int)fields.size() - 1 : column;
+  if (index >= (int)fields.size()) return false;
+  char* end;
+  *value = strtod(fields[index], &end);
+  while (*end == ' ') end++;
+  return end != fields[index] && *end == '\0';
+}
+
+static void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+// LSB-first bit packing for the Rice codes
+struct BitWriter {
+  std::vector<uint8_t>& out;
+  uint8_t bits = 0;
+  uint8_t used = 0;
+
+  explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+  void put(uint32_t v, uint8_t n) {
+    for (uint8_t i = 0; i < n; i++) {
+      bits |= (uint8_t)(((v >> i) & 1) << used);
+      if (++used == 8) flush();
+    }
+  }
+  void flush() {
+    if (used) out.push_back(bits);
+    bits = 0;
+    used = 0;
+  }
+};
+
+static void putRice(BitWriter& writer, uint32_t v, uint8_t shift) {
+  for (uint32_t ones = v >> shift; ones > 0; ones--) writer.put(1, 1);
+  writer.put(0, 1);
+  writer.put(v, shift);
+}
+
+// Zig-zag residuals of q[1..n-1] under the first- or second-order predictor
+static std::vector<uint32_t> residuals(const int32_t* q, size_t n, bool secondOrder) {
+  std::vector<uint32_t> r;
+  for (size_t i = 1; i < n; i++) {
+    int32_t predicted = secondOrder && i >= 2 ? 2 * q[i - 1] - q[i - 2] : q[i - 1];
+    r.push_back(windZigZag(q[i] - predicted));
+  }
+  return r;
+}
+
+// Block as WIND_ENCODING_RICE, with whichever shift and predictor give the fewest bits
+static void putRiceBlock(std::vector<uint8_t>& out, const int32_t* q, size_t n) {
+  uint64_t bestBits = UINT64_MAX;
+  uint8_t bestShift = 0;
+  bool bestSecondOrder = false;
+  for (int secondOrder = 0; secondOrder < 2; secondOrder++) {
+    std::vector<uint32_t> r = residuals(q, n, secondOrder);
+    for (uint8_t shift = 0; shift <= 24; shift++) {
+      uint64_t bits = 0;
+      for (uint32_t v : r) bits += (v >> shift) + 1 + shift;
+      if (bits < bestBits) {
+        bestBits = bits;
+        bestShift = shift;
+        bestSecondOrder = secondOrder;
+      }
+    }
+  }
+  putVarint(out, windZigZag(q[0]));
+  out.push_back(bestShift | (bestSecondOrder ? WIND_RICE_SECOND_ORDER : 0));
+  BitWriter writer(out);
+  for (uint32_t v : residuals(q, n, bestSecondOrder)) putRice(writer, v, bestShift);
+  writer.flush();
+}
+
+static void usage(void) {
+  fprintf(stderr, "usage: wind_encode [--column N] [--factor F] [--resolution KMH] [--encoding rice|delta|quant8]\n"
+                  "                   [--interval MS] [--block N] input.csv output.wnd\n");
+}
+
+int main(int argc, char** argv) {
+  int column = -1;
+  double factor = 1.0;
+  double resolution = 0.01;
+  uint8_t encoding = WIND_ENCODING_RICE;
+  long intervalMs = 1000;
+  long blockSize = 256;
+  const char* paths[2];
+  int pathCount = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--column") == 0 && i + 1 < argc) column = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--factor") == 0 && i + 1 < argc) factor = atof(argv[++i]);
+    else if (strcmp(argv[i], "--resolution") == 0 && i + 1 < argc) resolution = atof(argv[++i]);
+    else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) intervalMs = atol(argv[++i]);
+    else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc) blockSize = atol(argv[++i]);
+    else if (strcmp(argv[i], "--encoding") == 0 && i + 1 < argc) {
+      const char* name = argv[++i];
+      if (strcmp(name, "rice") == 0) encoding = WIND_ENCODING_RICE;
+      else if (strcmp(name, "delta") == 0) encoding = WIND_ENCODING_DELTA;
+      else if (strcmp(name, "quant8") == 0) encoding = WIND_ENCODING_QUANT8;
+      else {
+        usage();
+        return 2;
+      }
+    } else if (argv[i][0] != '-' && pathCount < 2) paths[pathCount++] = argv[i];
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (pathCount != 2 || resolution <= 0 || intervalMs <= 0 || intervalMs > 65535 || blockSize <= 0 || blockSize > 65535) {
+    usage();
+    return 2;
+  }
+
+  FILE* in = fopen(paths[0], "r");
+  if (in == NULL) {
+    fprintf(stderr, "cannot open %s\n", paths[0]);
+    return 2;
+  }
+  std::vector<double> values;
+  char line[1024];
+  while (fgets(line, sizeof(line), in)) {
+    double v;
+    if (line[0] != '#' && parseColumn(line, column, &v)) values.push_back(v * factor < 0 ? 0 : v * factor);
+  }
+  fclose(in);
+  if (values.empty()) {
+    fprintf(stderr, "no samples in %s\n", paths[0]);
+    return 2;
+  }
+
+  double lo = values[0], hi = values[0];
+  for (double v : values) {
+    if (v < lo) lo = v;
+    if (v > hi) hi = v;
+  }
+  double step = encoding == WIND_ENCODING_QUANT8 ? (hi > lo ? (hi - lo) / 255 : 1) : resolution;
+
+  WindProfileHeader header;
+  header.encoding = encoding;
+  header.intervalMs = (uint16_t)intervalMs;
+  header.sampleCount = (uint32_t)values.size();
+  header.offsetQ16 = (int32_t)lround(lo * 65536);
+  header.scaleQ16 = (uint32_t)lround(step * 65536);
+  if (header.scaleQ16 == 0) header.scaleQ16 = 1;
+  header.blockSize = (uint16_t)blockSize;
+  header.blockCount = (header.sampleCount + header.blockSize - 1) / header.blockSize;
+
+  // Quantize against the stored (rounded) offset and scale so the error is what the decoder sees
+  std::vector<uint8_t> body;
+  std::vector<uint32_t> index;
+  std::vector<int32_t> quantized;
+  double maxError = 0;
+  int32_t previous = 0;
+  for (size_t i = 0; i < values.size(); i++) {
+    int32_t q = (int32_t)lround((values[i] * 65536 - header.offsetQ16) / header.scaleQ16);
+    if (encoding == WIND_ENCODING_QUANT8) q = q < 0 ? 0 : (q > 255 ? 255 : q);
+    double decoded = (header.offsetQ16 + (double)q * header.scaleQ16) / 65536;
+    if (fabs(decoded - values[i]) > maxError) maxError = fabs(decoded - values[i]);
+
+    quantized.push_back(q);
+    if (encoding == WIND_ENCODING_RICE) continue;
+    if (i % header.blockSize == 0) index.push_back((uint32_t)body.size());
+    if (encoding == WIND_ENCODING_QUANT8) body.push_back((uint8_t)q);
+    else putVarint(body, windZigZag(i % header.blockSize == 0 ? q : q - previous));
+    previous = q;
+  }
+  if (encoding == WIND_ENCODING_RICE) {
+    for (size_t start = 0; start < quantized.size(); start += header.blockSize) {
+      index.push_back((uint32_t)body.size());
+      size_t n = quantized.size() - start < header.blockSize ? quantized.size() - start : header.blockSize;
+      putRiceBlock(body, &quantized[start], n);
+    }
+  }
+
+  FILE* out = fopen(paths[1], "wb");
+  if (out == NULL) {
+    fprintf(stderr, "cannot write %s\n", paths[1]);
+    return 2;
+  }
+  uint8_t raw[WIND_PROFILE_HEADER_SIZE];
+  windWriteHeader(raw, &header);
+  fwrite(raw, 1, sizeof(raw), out);
+  for (uint32_t offset : index) {
+    uint8_t entry[4];
+    windStore32(entry, offset);
+    fwrite(entry, 1, sizeof(entry), out);
+  }
+  fwrite(body.data(), 1, body.size(), out);
+  if (fclose(out) != 0) {
+    fprintf(stderr, "cannot write %s\n", paths[1]);
+    return 2;
+  }
+
+  size_t total = sizeof(raw) + index.size() * 4 + body.size();
+  printf("%zu samples, %zu bytes (%.2f bytes/sample, %.1fx smaller than float32), max error %.4f km/h\n",
+         values.size(), total, (double)total / values.size(), values.size() * 4.0 / total, maxError);
+  return 0;
+}